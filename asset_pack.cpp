@@ -0,0 +1,141 @@
+#include "asset_pack.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+const char ASSET_MAGIC[4] = {'D', 'X', 'A', 'P'};
+const std::uint32_t ASSET_VERSION = 1;
+const std::size_t ASSET_HEADER_SIZE = 16;
+const std::size_t ASSET_ALIGNMENT = 16;
+
+void putLittleEndian(std::vector<std::uint8_t> &out, std::uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        out.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+std::uint64_t getLittleEndian(const std::uint8_t *data, int bytes)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        value |= std::uint64_t(data[i]) << (8 * i);
+    }
+    return value;
+}
+}
+
+bool writeAssetPack(const std::string &path, const std::vector<std::string> &files, std::string &error)
+{
+    std::vector<std::vector<std::uint8_t>> contents;
+    std::size_t tableSize = 0;
+    for (const auto &name : files)
+    {
+        std::ifstream file(name, std::ios::binary);
+        if (!file.is_open() || name.size() > 0xFFFF)
+        {
+            error = "cannot read " + name;
+            return false;
+        }
+        contents.emplace_back((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        tableSize += 2 + name.size() + 16;
+    }
+
+    std::vector<std::uint8_t> out(ASSET_MAGIC, ASSET_MAGIC + 4);
+    putLittleEndian(out, ASSET_VERSION, 4);
+    putLittleEndian(out, files.size(), 4);
+    putLittleEndian(out, 0, 4);
+
+    std::size_t offset = ASSET_HEADER_SIZE + tableSize;
+    std::vector<std::size_t> offsets;
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        offset = (offset + ASSET_ALIGNMENT - 1) / ASSET_ALIGNMENT * ASSET_ALIGNMENT;
+        offsets.push_back(offset);
+        putLittleEndian(out, files[i].size(), 2);
+        out.insert(out.end(), files[i].begin(), files[i].end());
+        putLittleEndian(out, offset, 8);
+        putLittleEndian(out, contents[i].size(), 8);
+        offset += contents[i].size();
+    }
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        out.resize(offsets[i], 0);
+        out.insert(out.end(), contents[i].begin(), contents[i].end());
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    if (!file)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool AssetPack::open(const std::string &path)
+{
+    assets.clear();
+    if (!file.open(path))
+    {
+        return false;
+    }
+    const std::uint8_t *data = file.getData();
+    std::size_t size = file.getSize();
+    if (size < ASSET_HEADER_SIZE || std::memcmp(data, ASSET_MAGIC, 4) != 0 ||
+        getLittleEndian(data + 4, 4) != ASSET_VERSION)
+    {
+        file.close();
+        return false;
+    }
+
+    std::uint64_t count = getLittleEndian(data + 8, 4);
+    std::size_t position = ASSET_HEADER_SIZE;
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        if (size - position < 2)
+        {
+            break;
+        }
+        std::size_t nameLength = getLittleEndian(data + position, 2);
+        if (size - position - 2 < nameLength + 16)
+        {
+            break;
+        }
+        std::string name(reinterpret_cast<const char *>(data + position + 2), nameLength);
+        position += 2 + nameLength;
+        std::uint64_t offset = getLittleEndian(data + position, 8);
+        std::uint64_t length = getLittleEndian(data + position + 8, 8);
+        position += 16;
+        if (offset > size || length > size - offset)
+        {
+            break;
+        }
+        assets.push_back(Asset{name, data + offset, static_cast<std::size_t>(length)});
+    }
+    if (assets.size() != count)
+    {
+        assets.clear();
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+const Asset *AssetPack::find(const std::string &name) const
+{
+    for (const auto &asset : assets)
+    {
+        if (asset.name == name)
+        {
+            return &asset;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+// One file inside an AssetPack, pointing straight into the mapping.
+struct Asset
+{
+    std::string name;
+    const std::uint8_t *data;
+    std::size_t size;
+};
+
+// Pack file layout (little endian): "DXAP", u32 version, u32 asset count,
+// u32 reserved, then per asset a u16 name length, the name, u64 offset and
+// u64 size. Asset data is 16-byte aligned.
+bool writeAssetPack(const std::string &path, const std::vector<std::string> &files, std::string &error);
+
+// Every game asset in one memory-mapped file. Assets stay valid, without
+// copies, for as long as the pack is open, which sf::Font::loadFromMemory
+// relies on.
+class AssetPack
+{
+public:
+    bool open(const std::string &path);
+
+    // Null if the pack has no asset of that name.
+    const Asset *find(const std::string &name) const;
+    const std::vector<Asset> &getAssets() const { return assets; }
+
+private:
+    MappedFile file;
+    std::vector<Asset> assets;
+};
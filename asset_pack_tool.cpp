@@ -0,0 +1,36 @@
+// Bundles the game's font and sounds into the single pack file it loads at
+// startup. Assets are named by the paths given here.
+// Usage: asset-pack <pack.pak> <file>...
+
+#include <iostream>
+
+#include "asset_pack.hpp"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: asset-pack <pack.pak> <file>...\n";
+        return 1;
+    }
+
+    std::vector<std::string> files(argv + 2, argv + argc);
+    std::string error;
+    if (!writeAssetPack(argv[1], files, error))
+    {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    AssetPack pack;
+    if (!pack.open(argv[1]))
+    {
+        std::cerr << "Error reading back " << argv[1] << "\n";
+        return 1;
+    }
+    for (const auto &asset : pack.getAssets())
+    {
+        std::cout << asset.name << ": " << asset.size << " bytes\n";
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "audio.hpp"
+
+SoundBoard::SoundBoard()
+{
+    for (int i = 0; i < static_cast<int>(SoundEffect::Count); ++i)
+    {
+        loaded[i] = false;
+        minInterval[i] = sf::Time::Zero;
+        lastPlayed[i] = sf::Time::Zero;
+    }
+}
+
+bool SoundBoard::loadFromMemory(SoundEffect effect, const void *data, std::size_t size)
+{
+    int index = static_cast<int>(effect);
+    loaded[index] = buffers[index].loadFromMemory(data, size);
+    return loaded[index];
+}
+
+void SoundBoard::setMinInterval(SoundEffect effect, sf::Time interval)
+{
+    minInterval[static_cast<int>(effect)] = interval;
+}
+
+int SoundBoard::pickVoice()
+{
+    int oldest = 0;
+    for (int i = 0; i < SOUND_VOICES; ++i)
+    {
+        if (voices[i].getStatus() != sf::Sound::Playing)
+        {
+            return i;
+        }
+        if (voiceStarted[i] < voiceStarted[oldest])
+        {
+            oldest = i;
+        }
+    }
+    voices[oldest].stop();
+    return oldest;
+}
+
+void SoundBoard::play(SoundEffect effect)
+{
+    int index = static_cast<int>(effect);
+    if (!loaded[index])
+    {
+        return;
+    }
+    sf::Time now = clock.getElapsedTime();
+    if (lastPlayed[index] != sf::Time::Zero && now - lastPlayed[index] < minInterval[index])
+    {
+        return;
+    }
+    lastPlayed[index] = now;
+
+    int voice = pickVoice();
+    voices[voice].setBuffer(buffers[index]);
+    voices[voice].play();
+    voiceStarted[voice] = now;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+
+enum class SoundEffect
+{
+    Hit,
+    Cheer,
+    Count
+};
+
+const int SOUND_VOICES = 8;
+
+// Short effects decoded once into memory and played through a fixed pool of
+// voices. When every voice is busy the one that started longest ago is
+// reused, and each effect has a minimum retrigger interval so a burst of
+// brick hits in one step costs a single voice instead of the whole pool.
+class SoundBoard
+{
+public:
+    SoundBoard();
+
+    bool loadFromMemory(SoundEffect effect, const void *data, std::size_t size);
+    void setMinInterval(SoundEffect effect, sf::Time interval);
+
+    void play(SoundEffect effect);
+
+private:
+    int pickVoice();
+
+    sf::SoundBuffer buffers[static_cast<int>(SoundEffect::Count)];
+    bool loaded[static_cast<int>(SoundEffect::Count)];
+    sf::Time minInterval[static_cast<int>(SoundEffect::Count)];
+    sf::Time lastPlayed[static_cast<int>(SoundEffect::Count)];
+
+    sf::Sound voices[SOUND_VOICES];
+    sf::Time voiceStarted[SOUND_VOICES];
+    sf::Clock clock;
+};
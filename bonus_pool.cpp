@@ -0,0 +1,95 @@
+#include "bonus_pool.hpp"
+
+#include "state_io.hpp"
+
+BonusPool::BonusPool(int capacity) : capacity(capacity)
+{
+    bonuses.reserve(capacity);
+    owners.reserve(capacity);
+    slots.resize(capacity, Slot{0, 0});
+    freeSlots.reserve(capacity);
+    clear();
+}
+
+void BonusPool::clear()
+{
+    // Bumping every generation invalidates all outstanding handles.
+    for (auto &slot : slots)
+    {
+        slot.generation++;
+    }
+    bonuses.clear();
+    owners.clear();
+    freeSlots.clear();
+    for (int slot = capacity - 1; slot >= 0; --slot)
+    {
+        freeSlots.push_back(slot);
+    }
+}
+
+BonusHandle BonusPool::spawn(float x, float y, BonusType type)
+{
+    if (freeSlots.empty())
+    {
+        return BonusHandle();
+    }
+    std::uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    slots[slot].index = static_cast<std::uint32_t>(bonuses.size());
+    bonuses.emplace_back(x, y, type);
+    owners.push_back(slot);
+    return {slot, slots[slot].generation};
+}
+
+Bonus *BonusPool::get(BonusHandle handle)
+{
+    if (handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation)
+    {
+        return nullptr;
+    }
+    return &bonuses[slots[handle.slot].index];
+}
+
+void BonusPool::remove(BonusHandle handle)
+{
+    if (get(handle) != nullptr)
+    {
+        removeAt(slots[handle.slot].index);
+    }
+}
+
+void BonusPool::removeAt(int index)
+{
+    std::uint32_t slot = owners[index];
+    int last = size() - 1;
+    if (index != last)
+    {
+        bonuses[index] = bonuses[last];
+        owners[index] = owners[last];
+        slots[owners[index]].index = index;
+    }
+    bonuses.pop_back();
+    owners.pop_back();
+    slots[slot].generation++;
+    freeSlots.push_back(slot);
+}
+
+void BonusPool::save(StateWriter &out) const
+{
+    out.addArray(bonuses);
+}
+
+bool BonusPool::assign(const std::vector<Bonus> &loaded)
+{
+    if (static_cast<int>(loaded.size()) > capacity)
+    {
+        return false;
+    }
+    clear();
+    for (const Bonus &bonus : loaded)
+    {
+        spawn(0, 0, BonusType::None);
+        bonuses.back() = bonus;
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sim_types.hpp"
+
+class StateWriter;
+
+class Bonus
+{
+public:
+    Bonus(float startX, float startY, BonusType type) : position{startX, startY}, previousPosition(position), type(type) {}
+
+    void update(float dt)
+    {
+        previousPosition = position;
+        position.y += BONUS_FALL_SPEED * dt;
+    }
+
+    Vec2 getPosition(float alpha) const { return lerp(previousPosition, position, alpha); }
+    Rect getBounds() const { return {position.x, position.y, BRICK_WIDTH / 2, BRICK_HEIGHT / 2}; }
+    BonusType getType() const { return type; }
+
+private:
+    Vec2 position;
+    Vec2 previousPosition;
+    BonusType type;
+};
+
+// Stable reference to a pooled bonus. It goes stale, and BonusPool::get()
+// returns null, once that bonus is removed, even if its slot is reused.
+struct BonusHandle
+{
+    std::uint32_t slot = 0xFFFFFFFF;
+    std::uint32_t generation = 0;
+};
+
+// Fixed-capacity bonus storage. Live bonuses are packed at the front of one
+// preallocated array for iteration; spawn() and remove() are O(1) and never
+// allocate, with removal moving the last bonus into the hole. A free list of
+// slots maps handles to their current array position.
+class BonusPool
+{
+public:
+    explicit BonusPool(int capacity = MAX_BONUSES);
+
+    void clear();
+
+    // Returns a stale handle, and drops the bonus, when the pool is full.
+    BonusHandle spawn(float x, float y, BonusType type);
+    void remove(BonusHandle handle);
+
+    // Removes the bonus at position index; the last bonus takes its place.
+    void removeAt(int index);
+
+    Bonus *get(BonusHandle handle);
+    BonusHandle getHandle(int index) const { return {owners[index], slots[owners[index]].generation}; }
+
+    int size() const { return static_cast<int>(bonuses.size()); }
+    int getCapacity() const { return capacity; }
+    Bonus &operator[](int index) { return bonuses[index]; }
+    const Bonus &operator[](int index) const { return bonuses[index]; }
+    std::vector<Bonus>::const_iterator begin() const { return bonuses.begin(); }
+    std::vector<Bonus>::const_iterator end() const { return bonuses.end(); }
+
+    // Live bonuses in iteration order, for GameSim state snapshots. assign()
+    // replaces the contents and invalidates all handles; it returns false,
+    // changing nothing, if loaded exceeds the capacity.
+    void save(StateWriter &out) const;
+    bool assign(const std::vector<Bonus> &loaded);
+
+private:
+    struct Slot
+    {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    int capacity;
+    std::vector<Bonus> bonuses;
+    std::vector<std::uint32_t> owners; // slot of each bonus in the packed array
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots;
+};
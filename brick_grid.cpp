@@ -0,0 +1,107 @@
+#include "brick_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "brick_store.hpp"
+
+void BrickGrid::build(BrickStore &store)
+{
+    cellStart.clear();
+    columns = 0;
+    rows = 0;
+    if (store.size() == 0)
+    {
+        return;
+    }
+
+    Rect first = store.getBounds(0);
+    float right = first.left;
+    float bottom = first.top;
+    originX = first.left;
+    originY = first.top;
+    cellWidth = 1;
+    cellHeight = 1;
+    for (int i = 0; i < store.size(); ++i)
+    {
+        Rect bounds = store.getBounds(i);
+        originX = std::min(originX, bounds.left);
+        originY = std::min(originY, bounds.top);
+        right = std::max(right, bounds.left + bounds.width);
+        bottom = std::max(bottom, bounds.top + bounds.height);
+        cellWidth = std::max(cellWidth, bounds.width);
+        cellHeight = std::max(cellHeight, bounds.height);
+    }
+    // A few bricks spread far apart would need millions of mostly empty
+    // cells; widen the cells along the longer side until the grid is at most
+    // a few cells per brick.
+    const std::size_t maxCells = std::max<std::size_t>(64, 4 * static_cast<std::size_t>(store.size()));
+    while (true)
+    {
+        columns = static_cast<int>((right - originX) / cellWidth) + 1;
+        rows = static_cast<int>((bottom - originY) / cellHeight) + 1;
+        if (static_cast<std::size_t>(columns) * static_cast<std::size_t>(rows) <= maxCells)
+        {
+            break;
+        }
+        if (columns >= rows)
+        {
+            cellWidth *= 2;
+        }
+        else
+        {
+            cellHeight *= 2;
+        }
+    }
+
+    // Counting sort by cell; stable, so bricks keep their layout order within a cell.
+    std::vector<int> cellOf(store.size());
+    cellStart.assign(static_cast<std::size_t>(columns) * rows + 1, 0);
+    for (int i = 0; i < store.size(); ++i)
+    {
+        Rect bounds = store.getBounds(i);
+        int column = static_cast<int>((bounds.left - originX) / cellWidth);
+        int row = static_cast<int>((bounds.top - originY) / cellHeight);
+        cellOf[i] = cellIndex(column, row);
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (int cell = 0; cell < columns * rows; ++cell)
+    {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+    std::vector<int> next(cellStart.begin(), cellStart.end() - 1);
+    std::vector<int> order(store.size());
+    bool sorted = true;
+    for (int i = 0; i < store.size(); ++i)
+    {
+        int slot = next[cellOf[i]]++;
+        order[slot] = i;
+        sorted = sorted && slot == i;
+    }
+    // Level files are written in grid order, so loading them skips the shuffle.
+    if (!sorted)
+    {
+        store.permute(order);
+    }
+}
+
+void BrickGrid::query(const BrickStore &store, const Rect &area, std::vector<int> &out) const
+{
+    if (cellStart.empty())
+    {
+        return;
+    }
+    int firstColumn = std::max(0, static_cast<int>(std::floor((area.left - originX) / cellWidth)) - 1);
+    int firstRow = std::max(0, static_cast<int>(std::floor((area.top - originY) / cellHeight)) - 1);
+    int lastColumn = std::min(columns - 1, static_cast<int>(std::floor((area.left + area.width - originX) / cellWidth)));
+    int lastRow = std::min(rows - 1, static_cast<int>(std::floor((area.top + area.height - originY) / cellHeight)));
+
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        if (firstColumn > lastColumn)
+        {
+            break;
+        }
+        store.collectOverlaps(area, cellStart[cellIndex(firstColumn, row)], cellStart[cellIndex(lastColumn, row) + 1], out);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "sim_types.hpp"
+
+class BrickStore;
+
+// Uniform grid over the brick layout. build() sorts the store by cell, so each
+// cell is a contiguous range of brick indices and a row of cells is one range
+// that BrickStore::collectOverlaps() can scan with SIMD. Cells are at least as
+// large as the largest brick and a brick is filed under the cell of its
+// top-left corner, so a query looks one extra cell up and to the left. Sparse
+// layouts get larger cells so the grid stays within a few cells per brick.
+// Removing a brick is just BrickStore::destroy(); the grid never changes
+// until the next build().
+class BrickGrid
+{
+public:
+    void build(BrickStore &store);
+
+    // Appends the indices of live bricks overlapping area, in ascending order.
+    void query(const BrickStore &store, const Rect &area, std::vector<int> &out) const;
+
+private:
+    int cellIndex(int column, int row) const { return row * columns + column; }
+
+    float originX = 0;
+    float originY = 0;
+    float cellWidth = 1;
+    float cellHeight = 1;
+    int columns = 0;
+    int rows = 0;
+    std::vector<int> cellStart;
+};
@@ -0,0 +1,213 @@
+#include "brick_store.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "state_io.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+std::int16_t toInt16(float value)
+{
+    return static_cast<std::int16_t>(std::max(-32768.0f, std::min(32767.0f, value)));
+}
+}
+
+void BrickStore::clear()
+{
+    xs.clear();
+    ys.clear();
+    widths.clear();
+    heights.clear();
+    types.clear();
+    hitPoints.clear();
+    initialHitPoints.clear();
+    alive.clear();
+    aliveCount = 0;
+    unbreakableCount = 0;
+}
+
+int BrickStore::add(int x, int y, int width, int height, BonusType type, int hits)
+{
+    // Keep x + width and y + height inside 16 bits for the SIMD test.
+    int index = size();
+    xs.push_back(toInt16(x));
+    ys.push_back(toInt16(y));
+    widths.push_back(toInt16(std::min(width, 32767 - xs.back())));
+    heights.push_back(toInt16(std::min(height, 32767 - ys.back())));
+    types.push_back(static_cast<std::uint8_t>(type));
+    hitPoints.push_back(static_cast<std::uint8_t>(std::max(1, std::min<int>(UNBREAKABLE, hits))));
+    initialHitPoints.push_back(hitPoints.back());
+    unbreakableCount += hitPoints.back() == UNBREAKABLE;
+    if ((index & 63) == 0)
+    {
+        alive.push_back(0);
+    }
+    alive[index >> 6] |= std::uint64_t(1) << (index & 63);
+    aliveCount++;
+    return index;
+}
+
+void BrickStore::assign(int count, const std::int16_t *x, const std::int16_t *y, const std::int16_t *width,
+                        const std::int16_t *height, const std::uint8_t *type, const std::uint8_t *hits)
+{
+    xs.assign(x, x + count);
+    ys.assign(y, y + count);
+    widths.assign(width, width + count);
+    heights.assign(height, height + count);
+    types.assign(type, type + count);
+    if (hits)
+    {
+        hitPoints.assign(hits, hits + count);
+    }
+    else
+    {
+        hitPoints.assign(count, 1);
+    }
+    initialHitPoints = hitPoints;
+    unbreakableCount = static_cast<int>(std::count(hitPoints.begin(), hitPoints.end(), UNBREAKABLE));
+    alive.assign((count + 63) / 64, ~std::uint64_t(0));
+    if (count & 63)
+    {
+        alive.back() = (std::uint64_t(1) << (count & 63)) - 1;
+    }
+    aliveCount = count;
+}
+
+void BrickStore::permute(const std::vector<int> &order)
+{
+    BrickStore sorted;
+    for (int from : order)
+    {
+        int to = sorted.add(xs[from], ys[from], widths[from], heights[from], getBonusType(from), initialHitPoints[from]);
+        if (!isAlive(from))
+        {
+            sorted.destroy(to);
+        }
+        sorted.hitPoints[to] = hitPoints[from];
+    }
+    *this = std::move(sorted);
+}
+
+void BrickStore::destroy(int i)
+{
+    std::uint64_t bit = std::uint64_t(1) << (i & 63);
+    if (alive[i >> 6] & bit)
+    {
+        alive[i >> 6] &= ~bit;
+        aliveCount--;
+        unbreakableCount -= hitPoints[i] == UNBREAKABLE;
+    }
+    hitPoints[i] = 0;
+}
+
+int BrickStore::damage(int i)
+{
+    if (isAlive(i) && isBreakable(i) && --hitPoints[i] == 0)
+    {
+        destroy(i);
+    }
+    return hitPoints[i];
+}
+
+void BrickStore::collectOverlaps(const Rect &area, int first, int last, std::vector<int> &out) const
+{
+    // For whole-pixel bricks, x < right <=> x < ceil(right) and
+    // left < x + w <=> floor(left) < x + w, so the test stays exact.
+    std::int16_t left = toInt16(std::floor(area.left));
+    std::int16_t top = toInt16(std::floor(area.top));
+    std::int16_t right = toInt16(std::ceil(area.left + area.width));
+    std::int16_t bottom = toInt16(std::ceil(area.top + area.height));
+
+    int i = first;
+#if defined(__SSE2__)
+    const __m128i vLeft = _mm_set1_epi16(left);
+    const __m128i vTop = _mm_set1_epi16(top);
+    const __m128i vRight = _mm_set1_epi16(right);
+    const __m128i vBottom = _mm_set1_epi16(bottom);
+    for (; i + 8 <= last; i += 8)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&xs[i]));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&ys[i]));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&widths[i]));
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&heights[i]));
+        __m128i hit = _mm_and_si128(_mm_cmplt_epi16(x, vRight), _mm_cmpgt_epi16(_mm_add_epi16(x, w), vLeft));
+        hit = _mm_and_si128(hit, _mm_cmplt_epi16(y, vBottom));
+        hit = _mm_and_si128(hit, _mm_cmpgt_epi16(_mm_add_epi16(y, h), vTop));
+        int lanes = _mm_movemask_epi8(_mm_packs_epi16(hit, _mm_setzero_si128()));
+        while (lanes)
+        {
+            int index = i + __builtin_ctz(lanes);
+            if (isAlive(index))
+            {
+                out.push_back(index);
+            }
+            lanes &= lanes - 1;
+        }
+    }
+#endif
+    for (; i < last; ++i)
+    {
+        if (xs[i] < right && xs[i] + widths[i] > left && ys[i] < bottom && ys[i] + heights[i] > top && isAlive(i))
+        {
+            out.push_back(i);
+        }
+    }
+}
+
+void BrickStore::save(StateWriter &out) const
+{
+    out.addArray(xs);
+    out.addArray(ys);
+    out.addArray(widths);
+    out.addArray(heights);
+    out.addArray(types);
+    out.addArray(hitPoints);
+    out.addArray(initialHitPoints);
+    out.addArray(alive);
+}
+
+bool BrickStore::load(StateReader &in)
+{
+    const std::size_t maxBricks = 1 << 24;
+    BrickStore loaded;
+    in.readArray(loaded.xs, maxBricks);
+    in.readArray(loaded.ys, maxBricks);
+    in.readArray(loaded.widths, maxBricks);
+    in.readArray(loaded.heights, maxBricks);
+    in.readArray(loaded.types, maxBricks);
+    in.readArray(loaded.hitPoints, maxBricks);
+    in.readArray(loaded.initialHitPoints, maxBricks);
+    in.readArray(loaded.alive, maxBricks / 64);
+    std::size_t count = loaded.xs.size();
+    if (!in.isValid() || loaded.ys.size() != count || loaded.widths.size() != count || loaded.heights.size() != count ||
+        loaded.types.size() != count || loaded.hitPoints.size() != count ||
+        loaded.initialHitPoints.size() != count || loaded.alive.size() != (count + 63) / 64)
+    {
+        return false;
+    }
+    if ((count & 63) != 0 && (loaded.alive.back() >> (count & 63)) != 0)
+    {
+        return false;
+    }
+    // A brick is alive exactly when it has hit points left, never more than
+    // it started with; only unbreakable bricks have UNBREAKABLE.
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::uint8_t initial = loaded.initialHitPoints[i];
+        std::uint8_t now = loaded.hitPoints[i];
+        if (loaded.isAlive(static_cast<int>(i)) != (now != 0) || initial == 0 || now > initial ||
+            (initial == UNBREAKABLE && now != 0 && now != UNBREAKABLE))
+        {
+            return false;
+        }
+        loaded.aliveCount += loaded.isAlive(static_cast<int>(i));
+        loaded.unbreakableCount += loaded.hitPoints[i] == UNBREAKABLE;
+    }
+    *this = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sim_types.hpp"
+
+class StateReader;
+class StateWriter;
+
+// Hit points of a brick that no ball can break.
+const std::uint8_t UNBREAKABLE = 0xFF;
+
+// Structure-of-arrays brick field: packed 16-bit x/y/w/h, one type byte, hit
+// points now and at level load and one alive bit per brick, about 11 bytes
+// each. Brick coordinates are whole pixels, which keeps the integer overlap
+// test exact against float bounds.
+class BrickStore
+{
+public:
+    void clear();
+    int add(int x, int y, int width, int height, BonusType type, int hits = 1);
+
+    // Replaces the contents with count live bricks copied column by column,
+    // as stored in level files. x + width and y + height must fit in 16 bits.
+    // Without a hit point column every brick breaks on the first hit.
+    void assign(int count, const std::int16_t *x, const std::int16_t *y, const std::int16_t *width,
+                const std::int16_t *height, const std::uint8_t *type, const std::uint8_t *hits = nullptr);
+
+    // Reorders bricks so that order[i] becomes brick i. Used by BrickGrid to
+    // make every grid cell a contiguous index range.
+    void permute(const std::vector<int> &order);
+
+    int size() const { return static_cast<int>(xs.size()); }
+    int getAliveCount() const { return aliveCount; }
+    // Live bricks that still have to be broken to clear the level.
+    int getBreakableCount() const { return aliveCount - unbreakableCount; }
+    bool isAlive(int i) const { return (alive[i >> 6] >> (i & 63)) & 1; }
+    void destroy(int i);
+
+    // 0 once destroyed, UNBREAKABLE for bricks that never break.
+    int getHitPoints(int i) const { return hitPoints[i]; }
+    // What the brick had when the level was loaded.
+    int getInitialHitPoints(int i) const { return initialHitPoints[i]; }
+    bool isBreakable(int i) const { return hitPoints[i] != UNBREAKABLE; }
+    // Takes one hit point from a breakable brick, destroying it at zero, and
+    // returns what is left.
+    int damage(int i);
+
+    // One alive bit per brick, brick i at bit i % 64 of word i / 64.
+    const std::vector<std::uint64_t> &getAliveBits() const { return alive; }
+
+    Rect getBounds(int i) const { return {float(xs[i]), float(ys[i]), float(widths[i]), float(heights[i])}; }
+    BonusType getBonusType(int i) const { return static_cast<BonusType>(types[i]); }
+    void setBonusType(int i, BonusType type) { types[i] = static_cast<std::uint8_t>(type); }
+
+    // Appends, in ascending order, every live brick in [first, last) whose
+    // bounds overlap area (same strict rule as Rect::intersects).
+    void collectOverlaps(const Rect &area, int first, int last, std::vector<int> &out) const;
+
+    // Columns and alive bits for GameSim state snapshots. load() returns
+    // false, leaving the store unchanged, if the columns do not fit together.
+    void save(StateWriter &out) const;
+    bool load(StateReader &in);
+
+    // Same bricks in the same order, whatever their current hit points.
+    bool hasSameLayout(const BrickStore &other) const
+    {
+        return xs == other.xs && ys == other.ys && widths == other.widths && heights == other.heights &&
+               types == other.types && initialHitPoints == other.initialHitPoints;
+    }
+
+private:
+    std::vector<std::int16_t> xs;
+    std::vector<std::int16_t> ys;
+    std::vector<std::int16_t> widths;
+    std::vector<std::int16_t> heights;
+    std::vector<std::uint8_t> types;
+    std::vector<std::uint8_t> hitPoints;
+    std::vector<std::uint8_t> initialHitPoints;
+    std::vector<std::uint64_t> alive;
+    int aliveCount = 0;
+    int unbreakableCount = 0; // all of them alive
+};
@@ -0,0 +1,85 @@
+#include "collision.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Entry/exit times of center + motion * t along one axis of the slab [min, max].
+bool sweepAxis(float start, float motion, float min, float max, float &enter, float &exit)
+{
+    if (motion == 0)
+    {
+        enter = -std::numeric_limits<float>::infinity();
+        exit = std::numeric_limits<float>::infinity();
+        return start > min && start < max;
+    }
+    float t1 = (min - start) / motion;
+    float t2 = (max - start) / motion;
+    enter = std::fmin(t1, t2);
+    exit = std::fmax(t1, t2);
+    return true;
+}
+
+bool sweepCircleCorner(Vec2 center, Vec2 motion, float radius, Vec2 corner, SweepHit &hit)
+{
+    Vec2 offset = center - corner;
+    float a = dot(motion, motion);
+    float b = 2 * dot(offset, motion);
+    float c = dot(offset, offset) - radius * radius;
+    float discriminant = b * b - 4 * a * c;
+    if (a == 0 || discriminant <= 0)
+    {
+        return false;
+    }
+    float t = (-b - std::sqrt(discriminant)) / (2 * a);
+    if (t < 0 || t > 1)
+    {
+        return false;
+    }
+    hit.time = t;
+    hit.normal = (offset + motion * t) * (1 / radius);
+    return true;
+}
+}
+
+bool sweepCircleRect(Vec2 center, Vec2 motion, float radius, const Rect &rect, SweepHit &hit)
+{
+    float right = rect.left + rect.width;
+    float bottom = rect.top + rect.height;
+
+    float enterX, exitX, enterY, exitY;
+    if (!sweepAxis(center.x, motion.x, rect.left - radius, right + radius, enterX, exitX) ||
+        !sweepAxis(center.y, motion.y, rect.top - radius, bottom + radius, enterY, exitY))
+    {
+        return false;
+    }
+    float enter = std::fmax(enterX, enterY);
+    float exit = std::fmin(exitX, exitY);
+    if (enter >= exit || enter < 0 || enter > 1)
+    {
+        return false;
+    }
+
+    // The grown box has square corners; if we entered through one, the real
+    // shape is a quarter circle around the rectangle's corner.
+    Vec2 contact = center + motion * enter;
+    bool beyondX = contact.x < rect.left || contact.x > right;
+    bool beyondY = contact.y < rect.top || contact.y > bottom;
+    if (beyondX && beyondY)
+    {
+        Vec2 corner{contact.x < rect.left ? rect.left : right, contact.y < rect.top ? rect.top : bottom};
+        return sweepCircleCorner(center, motion, radius, corner, hit);
+    }
+
+    hit.time = enter;
+    if (enterX > enterY)
+    {
+        hit.normal = Vec2{motion.x > 0 ? -1.0f : 1.0f, 0};
+    }
+    else
+    {
+        hit.normal = Vec2{0, motion.y > 0 ? -1.0f : 1.0f};
+    }
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "sim_types.hpp"
+
+struct SweepHit
+{
+    float time;  // fraction of the motion, in [0, 1]
+    Vec2 normal; // unit surface normal at the contact, pointing at the circle
+};
+
+// Swept test of a circle moving from center by motion against a rectangle,
+// i.e. a ray against the rectangle grown by radius with rounded corners.
+// Starting inside or only grazing an edge does not count as a hit.
+bool sweepCircleRect(Vec2 center, Vec2 motion, float radius, const Rect &rect, SweepHit &hit);
+
+inline float dot(Vec2 a, Vec2 b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+inline Vec2 reflect(Vec2 velocity, Vec2 normal)
+{
+    return velocity - normal * (2 * dot(velocity, normal));
+}
@@ -1,31 +1,31 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 #include <vector>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <string>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
-
-const int WINDOW_WIDTH = 800;
-const int WINDOW_HEIGHT = 600;
-const int PADDLE_WIDTH = 200;
-const int PADDLE_HEIGHT = 20;
-const int BALL_RADIUS = 10;
-const int BRICK_WIDTH = 60;
-const int BRICK_HEIGHT = 20;
-const int BRICKS_PER_ROW = 10;
-const int BRICK_ROWS = 5;
-const int MAX_LIVES = 3;
-const float BONUS_FALL_SPEED = 0.1f;
-const float BONUS_DURATION = 200.0f;
-const int PADDLE_ENLARGED_WIDTH = 300;
-const int PADDLE_SHRUNKEN_WIDTH = 100;
-
-int score = 0;
+#include <thread>
+#include <unistd.h>
+
+#include "asset_pack.hpp"
+#include "audio.hpp"
+#include "hud.hpp"
+#include "input.hpp"
+#include "profiler.hpp"
+#include "render.hpp"
+#include "replay.hpp"
+#include "scores.hpp"
+#include "sim.hpp"
+#include "sim_thread.hpp"
+#include "spectator.hpp"
+
+const int DEFAULT_SIM_HZ = 240;
+const int DEFAULT_SPECTATOR_PORT = 47800;
 
 enum class GameState
 {
@@ -37,348 +37,367 @@ enum class GameState
     HighScore
 };
 
-enum class BonusType
-{
-    None,
-    EnlargePaddle,
-    ShrinkPaddle,
-    Fireball
-};
-
-class Paddle
+// Arrow keys follow the window's key events, which arrive on the window
+// thread. The sim thread reads the newest state at the moment it steps, so a
+// key event is picked up by the very next step instead of waiting for the
+// window's next frame. Every change gets an id for latency measurement.
+class KeyboardInput : public InputSource
 {
 public:
-    Paddle(float startX, float startY)
-    {
-        shape.setSize(sf::Vector2f(PADDLE_WIDTH, PADDLE_HEIGHT));
-        shape.setFillColor(sf::Color::Green);
-        shape.setPosition(startX, startY);
-    }
-
-    void move(float dx)
-    {
-        shape.move(dx, 0);
-        if (shape.getPosition().x < 0)
+    // Returns the id of the change, or 0 for other keys and key repeats.
+    std::uint64_t setKey(sf::Keyboard::Key key, bool pressed)
+    {
+        std::uint8_t bit = key == sf::Keyboard::Left ? packInput({true, false})
+                           : key == sf::Keyboard::Right ? packInput({false, true})
+                                                        : 0;
+        std::uint8_t newKeys = pressed ? keys | bit : keys & ~bit;
+        if (bit == 0 || newKeys == keys)
         {
-            shape.setPosition(0, shape.getPosition().y);
+            return 0;
         }
-        else if (shape.getPosition().x + shape.getSize().x > WINDOW_WIDTH)
-        {
-            shape.setPosition(WINDOW_WIDTH - shape.getSize().x, shape.getPosition().y);
-        }
-    }
-
-    void enlarge()
-    {
-        shape.setSize(sf::Vector2f(PADDLE_ENLARGED_WIDTH, PADDLE_HEIGHT));
+        keys = newKeys;
+        state.store(++eventCount << 8 | keys, std::memory_order_relaxed);
+        return eventCount;
     }
 
-    void shrink()
+    // Key releases are not delivered while the window is unfocused.
+    void releaseAll()
     {
-        shape.setSize(sf::Vector2f(PADDLE_SHRUNKEN_WIDTH, PADDLE_HEIGHT));
+        setKey(sf::Keyboard::Left, false);
+        setKey(sf::Keyboard::Right, false);
     }
 
-    void resetSize()
-    {
-        shape.setSize(sf::Vector2f(PADDLE_WIDTH, PADDLE_HEIGHT));
-    }
+    std::uint64_t getEventCount() const { return eventCount; }
 
-    sf::RectangleShape getShape() const
+    SimInput next(const GameSim &) override
     {
-        return shape;
+        std::uint64_t packed = state.load(std::memory_order_relaxed);
+        lastEventId = packed >> 8;
+        return unpackInput(packed & 0xFF);
     }
 
-    sf::FloatRect getBounds() const
-    {
-        return shape.getGlobalBounds();
-    }
+    std::uint64_t getLastEventId() const override { return lastEventId; }
 
 private:
-    sf::RectangleShape shape;
+    // Window thread.
+    std::uint8_t keys = 0;
+    std::uint64_t eventCount = 0;
+    // Event id above the key bits, so both are read in one load.
+    std::atomic<std::uint64_t> state{0};
+    // Sim thread.
+    std::uint64_t lastEventId = 0;
 };
 
-class Ball
+// mouse is in view coordinates, as tracked from the window's mouse events.
+bool isMouseOverText(const sf::Text &text, sf::Vector2f mouse)
 {
-public:
-    Ball(float startX, float startY)
-    {
-        shape.setRadius(BALL_RADIUS);
-        shape.setFillColor(sf::Color::Red);
-        shape.setPosition(startX, startY);
-        velocity.x = 0.05f;
-        velocity.y = -0.3f;
-        fireballActive = false;
-    }
-
-    void update()
-    {
-        shape.move(velocity);
-        if (shape.getPosition().x < 0 || shape.getPosition().x + BALL_RADIUS * 2 > WINDOW_WIDTH)
-        {
-            velocity.x = -velocity.x;
-        }
-        if (shape.getPosition().y < 0)
-        {
-            velocity.y = -velocity.y;
-        }
-    }
-
-    void bounce()
-    {
-        velocity.y = -velocity.y;
-    }
+    return text.getGlobalBounds().contains(mouse);
+}
 
-    sf::CircleShape getShape() const
+// Returns true if the hover color actually changed, i.e. a redraw is needed.
+bool updateTextColor(sf::Text &text, sf::Vector2f mouse)
+{
+    sf::Color color = isMouseOverText(text, mouse) ? sf::Color::Yellow : sf::Color::White;
+    if (text.getFillColor() == color)
     {
-        return shape;
+        return false;
     }
+    text.setFillColor(color);
+    return true;
+}
 
-    sf::FloatRect getBounds() const
-    {
-        return shape.getGlobalBounds();
-    }
+bool isPlayingState(GameState state)
+{
+    return state == GameState::Playing || state == GameState::Playing2;
+}
 
-    void setPosition(float x, float y)
+int parseIntOption(int argc, char *argv[], const std::string &name, int fallback, int minimum)
+{
+    for (int i = 1; i + 1 < argc; ++i)
     {
-        shape.setPosition(x, y);
+        if (argv[i] == name)
+        {
+            int value = std::atoi(argv[i + 1]);
+            if (value >= minimum)
+            {
+                return value;
+            }
+            std::cerr << "Ignoring invalid " << name << " value " << argv[i + 1] << "\n";
+        }
     }
+    return fallback;
+}
 
-    sf::Vector2f getVelocity() const
-    {
-        return velocity;
-    }
+// The simulation phases are timed on the sim thread and come in with the snapshot.
+std::string formatProfilerOverlay(const FrameProfiler &profiler, const double *simPhaseMs)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "frame ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\n",
+                  profiler.getFramePercentile(50), profiler.getFramePercentile(95),
+                  profiler.getFramePercentile(99), profiler.getFramePercentile(100));
+    std::string text = line;
+    for (int phase = 0; phase < static_cast<int>(ProfilePhase::Count); ++phase)
+    {
+        std::snprintf(line, sizeof(line), "%-12s %.3f ms\n", getPhaseName(static_cast<ProfilePhase>(phase)),
+                      profiler.getPhaseAverage(static_cast<ProfilePhase>(phase)) + simPhaseMs[phase]);
+        text += line;
+    }
+    return text;
+}
 
-    void activateFireball()
-    {
-        fireballActive = true;
-        shape.setFillColor(sf::Color::Yellow);
-    }
+std::string formatLatency(const LatencyRecorder &latency)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "input->present ms  n %d  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\n",
+                  latency.getCount(), latency.getPercentile(50), latency.getPercentile(95),
+                  latency.getPercentile(99), latency.getPercentile(100));
+    return line;
+}
 
-    void deactivateFireball()
+std::string parseStringOption(int argc, char *argv[], const std::string &name)
+{
+    for (int i = 1; i + 1 < argc; ++i)
     {
-        fireballActive = false;
-        shape.setFillColor(sf::Color::Red);
+        if (argv[i] == name)
+        {
+            return argv[i + 1];
+        }
     }
+    return "";
+}
 
-    bool isFireballActive() const
-    {
-        return fireballActive;
-    }
+// Directory of the running executable with a trailing slash, so assets are
+// found no matter which directory the game is started from.
+std::string getExecutableDir(const char *argv0)
+{
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    std::string executable = length > 0 ? std::string(path, length) : std::string(argv0);
+    std::size_t slash = executable.rfind('/');
+    return slash == std::string::npos ? "" : executable.substr(0, slash + 1);
+}
 
-private:
-    sf::CircleShape shape;
-    sf::Vector2f velocity;
-    bool fireballActive;
-};
+// Loads one asset out of the pack and reports how long it took.
+template <typename Load>
+bool loadAsset(const AssetPack &assets, const std::string &name, Load load)
+{
+    sf::Clock clock;
+    const Asset *asset = assets.find(name);
+    bool loaded = asset != nullptr && load(asset->data, asset->size);
+    std::cout << "asset " << name << (loaded ? "" : " FAILED") << ": " << clock.getElapsedTime().asMicroseconds() / 1000.0
+              << " ms\n";
+    return loaded;
+}
 
-class Brick
+// --spectate <host>[:port] mirrors a game streamed by --host-spectators.
+// The window only draws what arrives, interpolating from each state's
+// arrival; closing it or Escape ends the mirror.
+int runSpectator(sf::RenderWindow &window, const sf::Font &font, const std::string &address)
 {
-public:
-    Brick(float startX, float startY, BonusType bonusType) : bonusType(bonusType)
+    std::size_t colon = address.rfind(':');
+    int port = colon == std::string::npos ? DEFAULT_SPECTATOR_PORT : std::atoi(address.c_str() + colon + 1);
+    SpectatorClient client;
+    if (port <= 0 || port > 65535 || !client.connect(sf::IpAddress(address.substr(0, colon)), static_cast<unsigned short>(port)))
     {
-        shape.setSize(sf::Vector2f(BRICK_WIDTH, BRICK_HEIGHT));
-        shape.setFillColor(sf::Color::Blue);
-        shape.setPosition(startX, startY);
+        std::cerr << "Cannot spectate " << address << "\n";
+        return 1;
     }
 
-    sf::RectangleShape getShape() const
-    {
-        return shape;
-    }
+    GameSim mirror(1.0f / DEFAULT_SIM_HZ, 0);
+    SnapshotCapture capture;
+    FrameSnapshot snapshot;
+    bool hasSnapshot = false;
+    BatchRenderer renderer;
+    Hud hud(font, 24);
+    const int livesCounter = hud.addCounter("Lives: ", sf::Vector2f(10, 10));
+    const int scoreCounter = hud.addCounter("Score: ", sf::Vector2f(WINDOW_WIDTH - 100, 10));
+    sf::Text waitingText;
+    waitingText.setFont(font);
+    waitingText.setCharacterSize(36);
+    waitingText.setFillColor(sf::Color::White);
+    waitingText.setString("Waiting for host");
+    waitingText.setPosition(WINDOW_WIDTH / 2 - waitingText.getLocalBounds().width / 2, WINDOW_HEIGHT / 2 - 50);
 
-    sf::FloatRect getBounds() const
+    while (window.isOpen())
     {
-        return shape.getGlobalBounds();
-    }
+        sf::Event event;
+        while (window.pollEvent(event))
+        {
+            if (event.type == sf::Event::Closed ||
+                (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape))
+            {
+                window.close();
+            }
+        }
 
-    BonusType getBonusType() const
-    {
-        return bonusType;
-    }
+        if (client.poll() && mirror.loadState(client.getState()))
+        {
+            capture.capture(mirror, snapshot);
+            snapshot.dt = client.getDt();
+            snapshot.stepTime = client.getStateTime();
+            hasSnapshot = true;
+        }
 
-private:
-    sf::RectangleShape shape;
-    BonusType bonusType;
-};
+        window.clear();
+        if (hasSnapshot)
+        {
+            renderer.draw(window, snapshot, snapshot.getAlpha(FrameSnapshot::Clock::now()));
+            hud.setValue(livesCounter, snapshot.lives);
+            hud.setValue(scoreCounter, snapshot.score);
+            hud.draw(window);
+        }
+        else
+        {
+            window.draw(waitingText);
+        }
+        window.display();
+    }
+    return 0;
+}
 
-class Bonus
+int main(int argc, char *argv[])
 {
-public:
-    Bonus(float startX, float startY, BonusType type) : type(type)
-    {
-        shape.setSize(sf::Vector2f(BRICK_WIDTH / 2, BRICK_HEIGHT / 2));
-        shape.setFillColor(getColorForBonusType(type));
-        shape.setPosition(startX, startY);
-    }
+    // Every game gets its own seed; with --record the seed and the per-step
+    // input are saved so sim-replay can reproduce the game headlessly.
+    Rng seedSource(static_cast<std::uint64_t>(std::time(nullptr)));
+    std::string recordPath = parseStringOption(argc, argv, "--record");
 
-    void update()
-    {
-        shape.move(0, BONUS_FALL_SPEED);
-    }
+    // The simulation advances in fixed steps of simDt on its own thread;
+    // rendering runs as fast as it likes and interpolates between the last
+    // two steps of the newest snapshot.
+    const int simHz = parseIntOption(argc, argv, "--sim-hz", DEFAULT_SIM_HZ, 1);
+    const float simDt = 1.0f / simHz;
 
-    sf::RectangleShape getShape() const
-    {
-        return shape;
-    }
+    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "DX-Ball");
 
-    sf::FloatRect getBounds() const
+    // Gameplay is paced by vsync unless a frame limit is given (0 = uncapped).
+    // Menus block on events and only redraw when something visible changed.
+    int frameLimit = parseIntOption(argc, argv, "--fps-limit", -1, 0);
+    if (frameLimit >= 0)
     {
-        return shape.getGlobalBounds();
+        window.setFramerateLimit(frameLimit);
     }
-
-    BonusType getType() const
+    else
     {
-        return type;
+        window.setVerticalSyncEnabled(true);
     }
-
-private:
-    sf::RectangleShape shape;
-    BonusType type;
-
-    sf::Color getColorForBonusType(BonusType type)
-    {
-        switch (type)
+    bool needsRedraw = true;
+    GameState gameState = GameState::HomeScreen;
+    GameState drawnState = gameState;
+    GameSim sim(simDt, seedSource.next());
+
+    // --stress-balls N serves N balls at a time to load the collision code.
+    // Replays do not store it, so stress games are never recorded.
+    // --threads sets how many threads move balls (0 = one per core).
+    ThreadPool ballThreads(parseIntOption(argc, argv, "--threads", 0, 0));
+    sim.setThreadPool(&ballThreads);
+    sim.setStressBalls(parseIntOption(argc, argv, "--stress-balls", 0, 0));
+    if (sim.getBalls().size() > 1)
+    {
+        recordPath.clear();
+    }
+
+    // --autoplay hands the paddle to the bot instead of the arrow keys.
+    // --latency times every arrow key event until the first presented frame
+    // that reflects it and reports the percentiles on exit and in the overlay.
+    // Events carry no OS timestamp in SFML, so the clock starts when the
+    // window thread polls them.
+    KeyboardInput keyboardInput;
+    AutoPlayer autoPlayer;
+    InputSource *inputSource = &keyboardInput;
+    bool measureLatency = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--autoplay")
         {
-        case BonusType::EnlargePaddle:
-            return sf::Color::Yellow;
-        case BonusType::ShrinkPaddle:
-            return sf::Color::Magenta;
-        case BonusType::Fireball:
-            return sf::Color::Cyan;
-        default:
-            return sf::Color::White;
+            inputSource = &autoPlayer;
         }
-    }
-};
-
-class Score
-{
-public:
-    std::string name;
-    int score;
-};
-
-std::vector<Score> loadScores()
-{
-    std::vector<Score> high_scores;
-    std::ifstream file("high_scores.txt");
-    if (file.is_open())
-    {
-        std::string line;
-        while (std::getline(file, line))
+        else if (std::string(argv[i]) == "--latency")
         {
-            std::istringstream ss(line);
-            Score score;
-            ss >> score.name >> score.score;
-            high_scores.push_back(score);
+            measureLatency = true;
         }
-        file.close();
     }
-    return high_scores;
-}
+    const std::uint64_t LATENCY_WINDOW = 256; // key events in flight that can still be timed
+    std::vector<std::chrono::steady_clock::time_point> keyEventTimes(LATENCY_WINDOW);
+    std::uint64_t latencyMeasured = 0;
+    LatencyRecorder latency;
+    sf::Vector2f mouse(-1, -1);
 
-bool isHighScore(int score, std::vector<Score> high_scores)
-{
-    if (high_scores.size() < 5)
+    // --levels <pack> plays a level pack made by level-convert instead of
+    // the built-in random layouts. Replays do not store it either.
+    LevelPack levelPack;
+    std::string levelsPath = parseStringOption(argc, argv, "--levels");
+    if (!levelsPath.empty())
     {
-        return true;
-    }
-    for (auto s : high_scores)
-    {
-        if (score > s.score)
+        if (!levelPack.open(levelsPath))
         {
-            return true;
+            std::cerr << "Error loading level pack " << levelsPath << "\n";
+            return 1;
         }
+        sim.setLevelPack(&levelPack);
+        recordPath.clear();
+    }
+
+    // --host-spectators [address:]<port> streams every game to windows
+    // started with --spectate; 0 picks a free port. Only this machine can
+    // watch unless an address to listen on is given, such as 0.0.0.0:47800.
+    SpectatorHost spectatorHost;
+    const std::string spectatorOption = parseStringOption(argc, argv, "--host-spectators");
+    std::size_t spectatorColon = spectatorOption.rfind(':');
+    const int spectatorPort =
+        spectatorOption.empty() ? -1 : std::atoi(spectatorOption.c_str() + (spectatorColon == std::string::npos ? 0 : spectatorColon + 1));
+    const sf::IpAddress spectatorAddress =
+        spectatorColon == std::string::npos ? sf::IpAddress::LocalHost : sf::IpAddress(spectatorOption.substr(0, spectatorColon));
+    if (!spectatorOption.empty() && (spectatorPort < 0 || spectatorPort > 65535 || spectatorAddress == sf::IpAddress::None ||
+                                     !spectatorHost.open(static_cast<unsigned short>(spectatorPort), spectatorAddress)))
+    {
+        std::cerr << "Cannot host spectators on " << spectatorOption << "\n";
+        return 1;
     }
-    return false;
-}
 
-void saveScore(std::string name, int score, std::vector<Score> high_scores)
-{
-    high_scores.push_back({name, score});
-    if (high_scores.size() > 5)
+    // From here on the sim belongs to the sim thread; the window thread only
+    // looks at the snapshots it publishes.
+    SimThread simThread(sim, *inputSource);
+    if (spectatorPort >= 0)
     {
-        high_scores.erase(std::min_element(high_scores.begin(), high_scores.end(), [](Score a, Score b)
-                                           { return a.score < b.score; }));
+        std::cout << "hosting spectators on port " << spectatorHost.getPort() << "\n";
+        simThread.setStepObserver(&spectatorHost);
     }
-    std::sort(high_scores.begin(), high_scores.end(), [](Score a, Score b)
-              { return a.score > b.score; });
-    std::ofstream file("high_scores.txt");
-    for (auto s : high_scores)
-    {
-        file << s.name << " " << s.score << std::endl;
-    }
-    file.close();
-}
+    simThread.setRecording(!recordPath.empty());
+    std::uint64_t currentGame = 0;
+    long long bricksHitSeen = 0;
+    int levelsClearedSeen = 0;
+    int finalScore = 0;
 
-bool isMouseOverText(const sf::Text &text, const sf::RenderWindow &window)
-{
-    sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-    sf::FloatRect textBounds = text.getGlobalBounds();
-    return textBounds.contains(static_cast<sf::Vector2f>(mousePos));
-}
-
-void updateTextColor(sf::Text &text, const sf::RenderWindow &window)
-{
-    if (isMouseOverText(text, window))
+    auto startGame = [&]()
     {
-        text.setFillColor(sf::Color::Yellow);
-    }
-    else
+        gameState = GameState::Playing;
+        simThread.setRewinding(false);
+        currentGame = simThread.start(seedSource.next());
+        latencyMeasured = keyboardInput.getEventCount();
+        bricksHitSeen = 0;
+        levelsClearedSeen = 0;
+    };
+
+    // Font and sounds come from one memory-mapped pack next to the executable,
+    // or from --assets <pack>; build it with asset-pack.
+    std::string assetsPath = parseStringOption(argc, argv, "--assets");
+    if (assetsPath.empty())
     {
-        text.setFillColor(sf::Color::White);
+        assetsPath = getExecutableDir(argv[0]) + "assets.pak";
     }
-}
-
-void refillBricks(std::vector<Brick> &bricks, std::vector<Bonus> &bonuses)
-{
-    bricks.clear();
-    bonuses.clear();
-    for (int i = 0; i < BRICK_ROWS; ++i)
+    sf::Clock assetClock;
+    AssetPack assets;
+    if (!assets.open(assetsPath))
     {
-        for (int j = 0; j < BRICKS_PER_ROW; ++j)
-        {
-            BonusType bonusType = BonusType::None;
-            if (std::rand() % 5 == 0)
-            {
-                int bonusRand = std::rand() % 3;
-                if (bonusRand == 0)
-                {
-                    bonusType = BonusType::EnlargePaddle;
-                }
-                else if (bonusRand == 1)
-                {
-                    bonusType = BonusType::ShrinkPaddle;
-                }
-                else
-                {
-                    bonusType = BonusType::Fireball;
-                }
-            }
-            bricks.emplace_back(j * (BRICK_WIDTH + 10) + 30, i * (BRICK_HEIGHT + 10) + 30, bonusType);
-        }
+        std::cerr << "Error opening asset pack " << assetsPath << "\n";
+        return 1;
     }
-}
-
-void resetBallAndPaddle(Paddle &paddle, Ball &ball)
-{
-    paddle = Paddle(WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2, WINDOW_HEIGHT - PADDLE_HEIGHT - 10);
-    ball = Ball(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS);
-}
-
-int main()
-{
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-
-    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "DX-Ball");
-    GameState gameState = GameState::HomeScreen;
-    int lives = MAX_LIVES;
-    float bonusTimer = 0;
-    bool isBonusActive = false;
-    BonusType activeBonusType = BonusType::None;
+    std::cout << "asset pack " << assetsPath << ": " << assetClock.getElapsedTime().asMicroseconds() / 1000.0 << " ms\n";
 
     sf::Font font;
-    if (!font.loadFromFile("Font/gomarice_no_continue.ttf"))
+    if (!loadAsset(assets, "Font/gomarice_no_continue.ttf",
+                   [&](const void *data, std::size_t size) { return font.loadFromMemory(data, size); }))
     {
         std::cerr << "Error loading font\n";
         return 1;
@@ -441,17 +460,26 @@ int main()
     youWinTextExit.setString("Exit");
     youWinTextExit.setPosition(WINDOW_WIDTH / 2 - youWinTextExit.getLocalBounds().width / 2, WINDOW_HEIGHT / 2 + 50);
 
-    sf::Text livesText;
-    livesText.setFont(font);
-    livesText.setCharacterSize(24);
-    livesText.setFillColor(sf::Color::White);
-    livesText.setPosition(10, 10);
+    sf::Text nameText;
+    nameText.setFont(font);
+    nameText.setCharacterSize(24);
+    nameText.setFillColor(sf::Color::White);
+    auto showPlayerName = [&]()
+    {
+        nameText.setString("Enter your name: " + playerName);
+        nameText.setPosition(WINDOW_WIDTH / 2 - nameText.getLocalBounds().width / 2, WINDOW_HEIGHT / 2);
+    };
+    showPlayerName();
 
-    sf::Text scoreText;
-    scoreText.setFont(font);
-    scoreText.setCharacterSize(24);
-    scoreText.setFillColor(sf::Color::White);
-    scoreText.setPosition(WINDOW_WIDTH - 100, 10);
+    std::string spectateAddress = parseStringOption(argc, argv, "--spectate");
+    if (!spectateAddress.empty())
+    {
+        return runSpectator(window, font, spectateAddress);
+    }
+
+    Hud hud(font, 24);
+    const int livesCounter = hud.addCounter("Lives: ", sf::Vector2f(10, 10));
+    const int scoreCounter = hud.addCounter("Score: ", sf::Vector2f(WINDOW_WIDTH - 100, 10));
 
     sf::Text highScoreTextExit;
     highScoreTextExit.setFont(font);
@@ -461,6 +489,21 @@ int main()
 
     highScoreTextExit.setPosition(WINDOW_WIDTH / 2 - highScoreTextExit.getLocalBounds().width / 2, WINDOW_HEIGHT / 2 + 250);
 
+    // F3 toggles the profiler overlay; --trace <file> writes every frame's
+    // phase timings on exit, as CSV for *.csv and Chrome trace JSON otherwise.
+    // The sim thread's steps go to the same name with ".sim" before the extension.
+    FrameProfiler profiler;
+    std::string tracePath = parseStringOption(argc, argv, "--trace");
+    profiler.setTracing(!tracePath.empty());
+    simThread.setTracing(!tracePath.empty());
+    bool showProfiler = false;
+    sf::Clock profilerTextClock;
+    sf::Text profilerText;
+    profilerText.setFont(font);
+    profilerText.setCharacterSize(14);
+    profilerText.setFillColor(sf::Color::White);
+    profilerText.setPosition(10, 40);
+
     sf::Text highScoreText;
     highScoreText.setFont(font);
     highScoreText.setCharacterSize(30);
@@ -468,31 +511,103 @@ int main()
 
     highScoreText.setPosition(WINDOW_WIDTH / 2 - highScoreText.getLocalBounds().width / 2 - 50, WINDOW_HEIGHT / 2 - highScoreText.getLocalBounds().height / 2 - 100);
 
-    Paddle paddle(WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2, WINDOW_HEIGHT - PADDLE_HEIGHT - 10);
-    Ball ball(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS);
+    ScoreStore scoreStore("high_scores.txt");
+    unsigned highScoreTextVersion = scoreStore.getVersion() - 1;
 
     std::chrono::milliseconds inputDelay(200);
     auto lastInputTime = std::chrono::steady_clock::now();
 
-    std::vector<Brick> bricks;
-    std::vector<Bonus> bonuses;
-
-    refillBricks(bricks, bonuses);
+    BatchRenderer renderer;
 
-    sf::Music music;
-    if (!music.openFromFile("music/hit.ogg"))
+    SoundBoard sounds;
+    auto loadSound = [&](SoundEffect effect, const std::string &name)
+    {
+        return loadAsset(assets, name, [&](const void *data, std::size_t size) { return sounds.loadFromMemory(effect, data, size); });
+    };
+    if (!loadSound(SoundEffect::Hit, "music/hit.ogg") || !loadSound(SoundEffect::Cheer, "music/yeah.ogg"))
         return -1; // error
+    sounds.setMinInterval(SoundEffect::Hit, sf::milliseconds(40));
 
     while (window.isOpen())
     {
+        profiler.endFrame();
+        profiler.beginFrame();
+
         sf::Event event;
-        while (window.pollEvent(event))
+        bool hasEvent;
+        if (!isPlayingState(gameState) && !needsRedraw && gameState == drawnState)
+        {
+            hasEvent = window.waitEvent(event);
+            profiler.beginFrame();
+        }
+        else
+        {
+            hasEvent = window.pollEvent(event);
+        }
+        profiler.begin(ProfilePhase::Events);
+        for (; hasEvent; hasEvent = window.pollEvent(event))
         {
             if (event.type == sf::Event::Closed)
             {
                 window.close();
             }
 
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+            {
+                showProfiler = !showProfiler;
+                needsRedraw = true;
+            }
+
+            if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus)
+            {
+                needsRedraw = true;
+            }
+
+            if (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased)
+            {
+                std::uint64_t id = keyboardInput.setKey(event.key.code, event.type == sf::Event::KeyPressed);
+                if (id != 0)
+                {
+                    keyEventTimes[id % LATENCY_WINDOW] = std::chrono::steady_clock::now();
+                }
+            }
+            else if (event.type == sf::Event::LostFocus)
+            {
+                keyboardInput.releaseAll();
+                simThread.setRewinding(false);
+            }
+
+            // In a game F5 quick-saves, F9 quick-loads and holding R rewinds.
+            if (isPlayingState(gameState) && (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased))
+            {
+                bool pressed = event.type == sf::Event::KeyPressed;
+                if (event.key.code == sf::Keyboard::R)
+                {
+                    simThread.setRewinding(pressed);
+                }
+                else if (pressed && event.key.code == sf::Keyboard::F5)
+                {
+                    simThread.quickSave();
+                }
+                else if (pressed && event.key.code == sf::Keyboard::F9)
+                {
+                    simThread.quickLoad();
+                }
+            }
+
+            if (event.type == sf::Event::MouseMoved)
+            {
+                mouse = window.mapPixelToCoords(sf::Vector2i(event.mouseMove.x, event.mouseMove.y));
+            }
+            else if (event.type == sf::Event::MouseButtonPressed)
+            {
+                mouse = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
+            }
+            else if (event.type == sf::Event::MouseLeft)
+            {
+                mouse = sf::Vector2f(-1, -1);
+            }
+
             if (gameState == GameState::YouWin)
             {
                 if (event.type == sf::Event::TextEntered)
@@ -503,10 +618,14 @@ int main()
                         if (enteredChar == '\b' && !playerName.empty())
                         {
                             playerName.pop_back();
+                            showPlayerName();
+                            needsRedraw = true;
                         }
                         else if (std::isalpha(enteredChar))
                         {
                             playerName += std::toupper(enteredChar);
+                            showPlayerName();
+                            needsRedraw = true;
                         }
                     }
                 }
@@ -516,10 +635,10 @@ int main()
                     auto now = std::chrono::steady_clock::now();
                     if (now - lastInputTime > inputDelay)
                     {
-                        saveScore(playerName, score, loadScores());
+                        scoreStore.add(playerName, finalScore);
                         gameState = GameState::HomeScreen;
                         playerName.clear();
-                        score = 0;
+                        showPlayerName();
                         lastInputTime = now;
                     }
                 }
@@ -529,44 +648,15 @@ int main()
             {
                 if (event.type == sf::Event::MouseButtonPressed)
                 {
-                    if (isMouseOverText(homeTextStart, window))
+                    if (isMouseOverText(homeTextStart, mouse))
                     {
-                        gameState = GameState::Playing;
-                        lives = MAX_LIVES;
-                        paddle = Paddle(WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2, WINDOW_HEIGHT - PADDLE_HEIGHT - 10);
-                        ball = Ball(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS);
-                        bricks.clear();
-                        bonuses.clear();
-                        for (int i = 0; i < BRICK_ROWS; ++i)
-                        {
-                            for (int j = 0; j < BRICKS_PER_ROW; ++j)
-                            {
-                                BonusType bonusType = BonusType::None;
-                                if (std::rand() % 5 == 0)
-                                {
-                                    int bonusRand = std::rand() % 3;
-                                    if (bonusRand == 0)
-                                    {
-                                        bonusType = BonusType::EnlargePaddle;
-                                    }
-                                    else if (bonusRand == 1)
-                                    {
-                                        bonusType = BonusType::ShrinkPaddle;
-                                    }
-                                    else
-                                    {
-                                        bonusType = BonusType::Fireball;
-                                    }
-                                }
-                                bricks.emplace_back(j * (BRICK_WIDTH + 10) + 30, i * (BRICK_HEIGHT + 10) + 30, bonusType);
-                            }
-                        }
+                        startGame();
                     }
-                    else if (isMouseOverText(homeTextHighScore, window))
+                    else if (isMouseOverText(homeTextHighScore, mouse))
                     {
                         gameState = GameState::HighScore;
                     }
-                    else if (isMouseOverText(homeTextExit, window))
+                    else if (isMouseOverText(homeTextExit, mouse))
                     {
                         window.close();
                     }
@@ -577,7 +667,7 @@ int main()
             {
                 if (event.type == sf::Event::MouseButtonPressed)
                 {
-                    if (isMouseOverText(highScoreTextExit, window))
+                    if (isMouseOverText(highScoreTextExit, mouse))
                     {
                         gameState = GameState::HomeScreen;
                     }
@@ -588,40 +678,11 @@ int main()
             {
                 if (event.type == sf::Event::MouseButtonPressed)
                 {
-                    if (isMouseOverText(gameOverTextRestart, window))
+                    if (isMouseOverText(gameOverTextRestart, mouse))
                     {
-                        gameState = GameState::Playing;
-                        lives = MAX_LIVES;
-                        paddle = Paddle(WINDOW_WIDTH / 2 - PADDLE_WIDTH / 2, WINDOW_HEIGHT - PADDLE_HEIGHT - 10);
-                        ball = Ball(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS);
-                        bricks.clear();
-                        bonuses.clear();
-                        for (int i = 0; i < BRICK_ROWS; ++i)
-                        {
-                            for (int j = 0; j < BRICKS_PER_ROW; ++j)
-                            {
-                                BonusType bonusType = BonusType::None;
-                                if (std::rand() % 5 == 0)
-                                {
-                                    int bonusRand = std::rand() % 3;
-                                    if (bonusRand == 0)
-                                    {
-                                        bonusType = BonusType::EnlargePaddle;
-                                    }
-                                    else if (bonusRand == 1)
-                                    {
-                                        bonusType = BonusType::ShrinkPaddle;
-                                    }
-                                    else
-                                    {
-                                        bonusType = BonusType::Fireball;
-                                    }
-                                }
-                                bricks.emplace_back(j * (BRICK_WIDTH + 10) + 30, i * (BRICK_HEIGHT + 10) + 30, bonusType);
-                            }
-                        }
+                        startGame();
                     }
-                    else if (isMouseOverText(gameOverTextExit, window))
+                    else if (isMouseOverText(gameOverTextExit, mouse))
                     {
                         window.close();
                     }
@@ -629,291 +690,121 @@ int main()
             }
         }
 
-        if (gameState == GameState::Playing)
-        {
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))
-            {
-                paddle.move(-1.0f);
-            }
-            else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
-            {
-                paddle.move(1.0f);
-            }
+        profiler.end(ProfilePhase::Events);
 
-            ball.update();
+        if (!window.isOpen())
+        {
+            break;
+        }
 
-            if (ball.getBounds().intersects(paddle.getBounds()))
+        if (isPlayingState(gameState))
+        {
+            simThread.acquire();
+            const FrameSnapshot &snapshot = simThread.getSnapshot();
+            if (snapshot.game != currentGame)
             {
-                ball.bounce();
-                ball.setPosition(ball.getBounds().left, paddle.getBounds().top - BALL_RADIUS * 2);
+                // The new game's first snapshot is not out yet.
+                std::this_thread::yield();
+                continue;
             }
 
-            for (auto it = bricks.begin(); it != bricks.end();)
+            if (snapshot.bricksHit > bricksHitSeen)
             {
-                if (ball.getBounds().intersects(it->getBounds()))
-                {
-                    if (!ball.isFireballActive())
-                    {
-                        ball.bounce();
-                    }
-                    if (it->getBonusType() != BonusType::None)
-                    {
-                        bonuses.emplace_back(it->getBounds().left + BRICK_WIDTH / 2, it->getBounds().top + BRICK_HEIGHT / 2, it->getBonusType());
-                    }
-                    it = bricks.erase(it);
-
-                    music.play();
-                    score++;
-                }
-                else
-                {
-                    ++it;
-                }
+                sounds.play(SoundEffect::Hit);
             }
-
-            for (auto it = bonuses.begin(); it != bonuses.end();)
+            if (snapshot.levelsCleared > levelsClearedSeen)
             {
-                it->update();
-                if (it->getBounds().intersects(paddle.getBounds()))
+                sounds.play(SoundEffect::Cheer);
+                if (!snapshot.finished)
                 {
-                    if (it->getType() == BonusType::EnlargePaddle)
-                    {
-                        paddle.enlarge();
-                    }
-                    else if (it->getType() == BonusType::ShrinkPaddle)
-                    {
-                        paddle.shrink();
-                    }
-                    else if (it->getType() == BonusType::Fireball)
-                    {
-                        ball.activateFireball();
-                    }
-                    activeBonusType = it->getType();
-                    isBonusActive = true;
-                    bonusTimer = BONUS_DURATION;
-                    it = bonuses.erase(it);
-                }
-                else if (it->getBounds().top > WINDOW_HEIGHT)
-                {
-                    it = bonuses.erase(it);
-                }
-                else
-                {
-                    ++it;
+                    gameState = GameState::Playing2;
+                    std::cout << "Playing2" << std::endl;
                 }
             }
+            bricksHitSeen = snapshot.bricksHit;
+            levelsClearedSeen = snapshot.levelsCleared;
 
-            if (isBonusActive)
+            if (snapshot.finished)
             {
-                bonusTimer -= 1.0f / 60.0f; // 60 fps
-                if (bonusTimer <= 0)
+                if (!recordPath.empty() && !saveReplay(simThread.getRecording(), recordPath))
                 {
-                    paddle.resetSize();
-                    ball.deactivateFireball();
-                    isBonusActive = false;
-                    activeBonusType = BonusType::None;
+                    std::cerr << "Error saving replay to " << recordPath << "\n";
                 }
-            }
-
-            if (ball.getBounds().top + BALL_RADIUS * 2 > WINDOW_HEIGHT)
-            {
-                lives--;
-                if (lives > 0)
+                finalScore = snapshot.score;
+                if (scoreStore.isHighScore(snapshot.score))
                 {
-                    ball = Ball(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS);
-                    if (ball.isFireballActive())
-                    {
-                        ball.deactivateFireball();
-                    }
+                    gameState = GameState::YouWin;
                 }
                 else
                 {
-
-                    if (isHighScore(score, loadScores()))
-                    {
-                        gameState = GameState::YouWin;
-                    }
-                    else
-                    {
-                        gameState = GameState::GameOver;
-                        score = 0;
-                    }
+                    gameState = GameState::GameOver;
                 }
+                // This frame still shows the playfield; the end screen has
+                // to be drawn before the menu loop waits for events.
+                needsRedraw = true;
             }
+            float alpha = snapshot.getAlpha(FrameSnapshot::Clock::now());
 
-            if (bricks.empty())
-            {
-                gameState = GameState::Playing2;
-                refillBricks(bricks, bonuses);
-                resetBallAndPaddle(paddle, ball);
-                std::cout << "Playing2" << std::endl;
-            }
-
+            profiler.begin(ProfilePhase::Render);
             window.clear();
-            window.draw(paddle.getShape());
-            window.draw(ball.getShape());
-            for (const auto &brick : bricks)
-            {
-                window.draw(brick.getShape());
-            }
-            for (const auto &bonus : bonuses)
-            {
-                window.draw(bonus.getShape());
-            }
-            livesText.setString("Lives: " + std::to_string(lives));
-            window.draw(livesText);
-            scoreText.setString("Score: " + std::to_string(score));
-            window.draw(scoreText);
-            window.display();
-        }
-        else if (gameState == GameState::Playing2)
-        {
+            renderer.draw(window, snapshot, alpha);
+            profiler.end(ProfilePhase::Render);
 
-            // std::cout << "Here" << std::endl;
+            profiler.begin(ProfilePhase::Hud);
+            hud.setValue(livesCounter, snapshot.lives);
+            hud.setValue(scoreCounter, snapshot.score);
+            hud.draw(window);
+            profiler.end(ProfilePhase::Hud);
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))
+            if (showProfiler)
             {
-                paddle.move(-1.0f);
-            }
-            else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
-            {
-                paddle.move(1.0f);
-            }
-
-            ball.update();
-
-            if (ball.getBounds().intersects(paddle.getBounds()))
-            {
-                ball.bounce();
-                ball.setPosition(ball.getBounds().left, paddle.getBounds().top - BALL_RADIUS * 2);
-            }
-
-            for (auto it = bricks.begin(); it != bricks.end();)
-            {
-                if (ball.getBounds().intersects(it->getBounds()))
-                {
-                    if (!ball.isFireballActive())
-                    {
-                        ball.bounce();
-                    }
-                    if (it->getBonusType() != BonusType::None)
-                    {
-                        bonuses.emplace_back(it->getBounds().left + BRICK_WIDTH / 2, it->getBounds().top + BRICK_HEIGHT / 2, it->getBonusType());
-                    }
-                    it = bricks.erase(it);
-                    score++;
-                }
-                else
-                {
-                    ++it;
-                }
-            }
-
-            for (auto it = bonuses.begin(); it != bonuses.end();)
-            {
-                it->update();
-                if (it->getBounds().intersects(paddle.getBounds()))
-                {
-                    if (it->getType() == BonusType::EnlargePaddle)
-                    {
-                        paddle.enlarge();
-                    }
-                    else if (it->getType() == BonusType::ShrinkPaddle)
-                    {
-                        paddle.shrink();
-                    }
-                    else if (it->getType() == BonusType::Fireball)
-                    {
-                        ball.activateFireball();
-                    }
-                    activeBonusType = it->getType();
-                    isBonusActive = true;
-                    bonusTimer = BONUS_DURATION;
-                    it = bonuses.erase(it);
-                }
-                else if (it->getBounds().top > WINDOW_HEIGHT)
+                if (profilerTextClock.getElapsedTime() > sf::milliseconds(250))
                 {
-                    it = bonuses.erase(it);
-                }
-                else
-                {
-                    ++it;
+                    profilerText.setString(formatProfilerOverlay(profiler, snapshot.phaseMs) +
+                                           (measureLatency ? formatLatency(latency) : ""));
+                    profilerTextClock.restart();
                 }
+                window.draw(profilerText);
             }
 
-            if (isBonusActive)
-            {
-                bonusTimer -= 1.0f / 60.0f; // 60 fps
-                if (bonusTimer <= 0)
-                {
-                    paddle.resetSize();
-                    ball.deactivateFireball();
-                    isBonusActive = false;
-                    activeBonusType = BonusType::None;
-                }
-            }
-
-            if (ball.getBounds().top + BALL_RADIUS * 2 > WINDOW_HEIGHT)
+            profiler.begin(ProfilePhase::Present);
+            window.display();
+            profiler.end(ProfilePhase::Present);
+            if (measureLatency && snapshot.inputEvent > latencyMeasured)
             {
-                lives--;
-                if (lives > 0)
+                auto presented = std::chrono::steady_clock::now();
+                std::uint64_t first = latencyMeasured + 1;
+                if (snapshot.inputEvent - latencyMeasured > LATENCY_WINDOW)
                 {
-                    ball = Ball(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS);
-                    if (ball.isFireballActive())
-                    {
-                        ball.deactivateFireball();
-                    }
+                    first = snapshot.inputEvent - LATENCY_WINDOW + 1; // older timestamps were overwritten
                 }
-                else
+                for (std::uint64_t id = first; id <= snapshot.inputEvent; ++id)
                 {
-                    // gameState = GameState::GameOver;
-                    if (isHighScore(score, loadScores()))
-                    {
-                        gameState = GameState::YouWin;
-                    }
-                    else
-                    {
-                        gameState = GameState::GameOver;
-                        score = 0;
-                    }
+                    latency.add(std::chrono::duration<double, std::milli>(presented - keyEventTimes[id % LATENCY_WINDOW]).count());
                 }
+                latencyMeasured = snapshot.inputEvent;
             }
+            drawnState = gameState;
+            continue;
+        }
 
-            if (bricks.empty())
-            {
-                if (isHighScore(score, loadScores()))
-                {
-                    gameState = GameState::YouWin;
-                }
-                else
-                {
-                    gameState = GameState::GameOver;
-                    score = 0;
-                }
-            }
+        // Menu screens: only redraw when the screen, a hover color or the
+        // entered text changed since the last frame we presented.
+        if (gameState != drawnState)
+        {
+            needsRedraw = true;
+            drawnState = gameState;
+        }
 
-            window.clear();
-            window.draw(paddle.getShape());
-            window.draw(ball.getShape());
-            for (const auto &brick : bricks)
-            {
-                window.draw(brick.getShape());
-            }
-            for (const auto &bonus : bonuses)
+        if (gameState == GameState::HomeScreen)
+        {
+            needsRedraw |= updateTextColor(homeTextStart, mouse);
+            needsRedraw |= updateTextColor(homeTextExit, mouse);
+            needsRedraw |= updateTextColor(homeTextHighScore, mouse);
+            if (!needsRedraw)
             {
-                window.draw(bonus.getShape());
+                continue;
             }
-            livesText.setString("Lives: " + std::to_string(lives));
-            window.draw(livesText);
-            scoreText.setString("Score: " + std::to_string(score));
-            window.draw(scoreText);
-            window.display();
-        }
-        else if (gameState == GameState::HomeScreen)
-        {
-            homeTextStart.setFillColor(isMouseOverText(homeTextStart, window) ? sf::Color::Yellow : sf::Color::White);
-            homeTextExit.setFillColor(isMouseOverText(homeTextExit, window) ? sf::Color::Yellow : sf::Color::White);
-            homeTextHighScore.setFillColor(isMouseOverText(homeTextHighScore, window) ? sf::Color::Yellow : sf::Color::White);
             window.clear();
             window.draw(homeTextStart);
             window.draw(homeTextExit);
@@ -922,9 +813,12 @@ int main()
         }
         else if (gameState == GameState::GameOver)
         {
-
-            gameOverTextRestart.setFillColor(isMouseOverText(gameOverTextRestart, window) ? sf::Color::Yellow : sf::Color::White);
-            gameOverTextExit.setFillColor(isMouseOverText(gameOverTextExit, window) ? sf::Color::Yellow : sf::Color::White);
+            needsRedraw |= updateTextColor(gameOverTextRestart, mouse);
+            needsRedraw |= updateTextColor(gameOverTextExit, mouse);
+            if (!needsRedraw)
+            {
+                continue;
+            }
             window.clear();
             window.draw(gameOverTextRestart);
             window.draw(gameOverTextExit);
@@ -932,15 +826,12 @@ int main()
         }
         else if (gameState == GameState::YouWin)
         {
-            youWinText.setFillColor(isMouseOverText(youWinText, window) ? sf::Color::Yellow : sf::Color::White);
-            youWinTextExit.setFillColor(isMouseOverText(youWinTextExit, window) ? sf::Color::Yellow : sf::Color::White);
-
-            sf::Text nameText;
-            nameText.setFont(font);
-            nameText.setCharacterSize(24);
-            nameText.setFillColor(sf::Color::White);
-            nameText.setString("Enter your name: " + playerName);
-            nameText.setPosition(WINDOW_WIDTH / 2 - nameText.getLocalBounds().width / 2, WINDOW_HEIGHT / 2);
+            needsRedraw |= updateTextColor(youWinText, mouse);
+            needsRedraw |= updateTextColor(youWinTextExit, mouse);
+            if (!needsRedraw)
+            {
+                continue;
+            }
 
             window.clear();
             window.draw(nameText);
@@ -951,26 +842,67 @@ int main()
         {
             if (event.type == sf::Event::MouseButtonPressed)
             {
-                if (isMouseOverText(homeTextExit, window))
+                if (isMouseOverText(homeTextExit, mouse))
                 {
                     window.close();
                 }
             }
 
-            std::vector<Score> high_scores = loadScores();
-            std::string high_score_text = "High Scores\n";
-            for (auto s : high_scores)
+            needsRedraw |= updateTextColor(highScoreTextExit, mouse);
+            if (!needsRedraw)
             {
-                high_score_text += s.name + " " + std::to_string(s.score) + "\n";
+                continue;
+            }
+
+            if (highScoreTextVersion != scoreStore.getVersion())
+            {
+                std::string high_score_text = "High Scores\n";
+                for (const auto &s : scoreStore.getScores())
+                {
+                    high_score_text += s.name + " " + std::to_string(s.score) + "\n";
+                }
+                highScoreText.setString(high_score_text);
+                highScoreTextVersion = scoreStore.getVersion();
             }
-            highScoreTextExit.setFillColor(isMouseOverText(highScoreTextExit, window) ? sf::Color::Yellow : sf::Color::White);
-            highScoreText.setString(high_score_text);
             window.clear();
             window.draw(highScoreText);
             window.draw(highScoreTextExit);
 
             window.display();
         }
+        needsRedraw = false;
+    }
+
+    simThread.stop();
+    if (measureLatency)
+    {
+        std::cout << formatLatency(latency);
+    }
+    if (spectatorPort >= 0)
+    {
+        std::cout << "spectator stream: " << spectatorHost.getStatesSent() << " states in "
+                  << spectatorHost.getPacketsSent() << " packets, " << spectatorHost.getBytesSent() / 1024 << " KB, "
+                  << spectatorHost.getKeyframesSent() << " whole, " << spectatorHost.getFragmentedStates()
+                  << " fragmented\n";
+    }
+    if (!tracePath.empty())
+    {
+        auto writeTrace = [](const FrameProfiler &traced, const std::string &path)
+        {
+            bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+            if (!(csv ? traced.writeCsv(path) : traced.writeChromeTrace(path)))
+            {
+                std::cerr << "Error writing trace to " << path << "\n";
+            }
+        };
+        std::size_t dot = tracePath.rfind('.');
+        std::size_t slash = tracePath.rfind('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        {
+            dot = tracePath.size();
+        }
+        writeTrace(profiler, tracePath);
+        writeTrace(simThread.getProfiler(), tracePath.substr(0, dot) + ".sim" + tracePath.substr(dot));
     }
 
     return 0;
@@ -0,0 +1,96 @@
+#include "hud.hpp"
+
+Hud::Hud(const sf::Font &font, unsigned characterSize)
+    : font(font), characterSize(characterSize), vertices(sf::Triangles), labelVertexCount(0), valuesDirty(false)
+{
+    for (int digit = 0; digit < 10; ++digit)
+    {
+        digits[digit] = font.getGlyph('0' + digit, characterSize, false);
+    }
+}
+
+// Appends one glyph quad with its origin on the baseline at pen, the way
+// sf::Text places glyphs, and returns its advance.
+float Hud::appendGlyph(sf::VertexArray &target, const sf::Glyph &glyph, sf::Vector2f pen)
+{
+    float left = pen.x + glyph.bounds.left;
+    float top = pen.y + glyph.bounds.top;
+    float right = left + glyph.bounds.width;
+    float bottom = top + glyph.bounds.height;
+    float u1 = static_cast<float>(glyph.textureRect.left);
+    float v1 = static_cast<float>(glyph.textureRect.top);
+    float u2 = u1 + glyph.textureRect.width;
+    float v2 = v1 + glyph.textureRect.height;
+    target.append(sf::Vertex(sf::Vector2f(left, top), sf::Color::White, sf::Vector2f(u1, v1)));
+    target.append(sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u2, v1)));
+    target.append(sf::Vertex(sf::Vector2f(right, bottom), sf::Color::White, sf::Vector2f(u2, v2)));
+    target.append(sf::Vertex(sf::Vector2f(left, top), sf::Color::White, sf::Vector2f(u1, v1)));
+    target.append(sf::Vertex(sf::Vector2f(right, bottom), sf::Color::White, sf::Vector2f(u2, v2)));
+    target.append(sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u1, v2)));
+    return glyph.advance;
+}
+
+int Hud::addCounter(const std::string &label, sf::Vector2f position)
+{
+    // Labels live at the front of the array; values are rebuilt behind them.
+    vertices.resize(labelVertexCount);
+    sf::Vector2f pen(position.x, position.y + characterSize);
+    sf::Uint32 previous = 0;
+    for (char c : label)
+    {
+        sf::Uint32 codepoint = static_cast<unsigned char>(c);
+        pen.x += font.getKerning(previous, codepoint, characterSize);
+        pen.x += appendGlyph(vertices, font.getGlyph(codepoint, characterSize, false), pen);
+        previous = codepoint;
+    }
+    labelVertexCount = vertices.getVertexCount();
+
+    counters.push_back(Counter{pen, 0});
+    valuesDirty = true;
+    return static_cast<int>(counters.size()) - 1;
+}
+
+void Hud::setValue(int counter, int value)
+{
+    if (counters[counter].value != value)
+    {
+        counters[counter].value = value;
+        valuesDirty = true;
+    }
+}
+
+void Hud::rebuildValues()
+{
+    vertices.resize(labelVertexCount);
+    for (const auto &counter : counters)
+    {
+        char text[12];
+        int length = 0;
+        unsigned value = counter.value < 0 ? 0u - counter.value : counter.value;
+        do
+        {
+            text[length++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+
+        sf::Vector2f pen = counter.valuePosition;
+        if (counter.value < 0)
+        {
+            pen.x += appendGlyph(vertices, font.getGlyph('-', characterSize, false), pen);
+        }
+        while (length > 0)
+        {
+            pen.x += appendGlyph(vertices, digits[text[--length] - '0'], pen);
+        }
+    }
+    valuesDirty = false;
+}
+
+void Hud::draw(sf::RenderTarget &target)
+{
+    if (valuesDirty)
+    {
+        rebuildValues();
+    }
+    target.draw(vertices, sf::RenderStates(&font.getTexture(characterSize)));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Labelled counters ("Score: 42") drawn from cached glyph quads in one draw
+// call. Labels are laid out once when a counter is added, the digit glyphs
+// are looked up once up front, and the digit quads are rebuilt only when a
+// value actually changes, so steady frames do no text layout at all.
+class Hud
+{
+public:
+    Hud(const sf::Font &font, unsigned characterSize);
+
+    // Returns the id to pass to setValue().
+    int addCounter(const std::string &label, sf::Vector2f position);
+    void setValue(int counter, int value);
+
+    void draw(sf::RenderTarget &target);
+
+private:
+    struct Counter
+    {
+        sf::Vector2f valuePosition;
+        int value;
+    };
+
+    float appendGlyph(sf::VertexArray &vertices, const sf::Glyph &glyph, sf::Vector2f pen);
+    void rebuildValues();
+
+    const sf::Font &font;
+    unsigned characterSize;
+    sf::Glyph digits[10];
+    std::vector<Counter> counters;
+    sf::VertexArray vertices;
+    std::size_t labelVertexCount;
+    bool valuesDirty;
+};
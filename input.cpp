@@ -0,0 +1,134 @@
+#include "input.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+bool isWanted(BonusType type)
+{
+    return type == BonusType::EnlargePaddle || type == BonusType::Fireball || type == BonusType::MultiBall;
+}
+
+// Reflects x back into [low, high] as often as needed, like a ball bouncing
+// between the two side walls.
+float foldBetweenWalls(float x, float low, float high)
+{
+    float span = high - low;
+    if (span <= 0)
+    {
+        return low;
+    }
+    float offset = std::fmod(x - low, 2 * span);
+    if (offset < 0)
+    {
+        offset += 2 * span;
+    }
+    return low + (offset <= span ? offset : 2 * span - offset);
+}
+}
+
+bool AutoPlayer::predictBall(const GameSim &sim, float &time, float &x) const
+{
+    float paddleTop = sim.getPaddle().getPosition().y;
+    bool found = false;
+    for (const auto &ball : sim.getBalls())
+    {
+        Vec2 velocity = ball.getVelocity();
+        float bottom = ball.getPosition().y + BALL_RADIUS * 2;
+        if (velocity.y <= 0 || bottom > paddleTop + sim.getPaddle().getSize().y)
+        {
+            continue;
+        }
+        float arrival = std::max(0.0f, (paddleTop - bottom) / velocity.y);
+        if (!found || arrival < time)
+        {
+            time = arrival;
+            float left = foldBetweenWalls(ball.getPosition().x + velocity.x * arrival, 0, WINDOW_WIDTH - BALL_RADIUS * 2);
+            x = left + BALL_RADIUS;
+            found = true;
+        }
+    }
+    return found;
+}
+
+SimInput AutoPlayer::next(const GameSim &sim)
+{
+    const Paddle &paddle = sim.getPaddle();
+    const float speed = sim.getConfig().paddleSpeed;
+    float paddleCenter = paddle.getPosition().x + paddle.getSize().x / 2;
+    float paddleTop = paddle.getPosition().y;
+
+    float ballTime = 0;
+    float target = paddleCenter;
+    bool ballComing = predictBall(sim, ballTime, target);
+    if (ballComing && !ballWasComing && aimError > 0)
+    {
+        aimOffset = (rng.below(2001) / 1000.0f - 1) * aimError;
+    }
+    ballWasComing = ballComing;
+    target += aimOffset;
+    if (!ballComing && !sim.getBalls().empty())
+    {
+        // Nothing descending yet: wait under the lowest ball.
+        const Ball *lowest = &sim.getBalls().front();
+        for (const auto &ball : sim.getBalls())
+        {
+            if (ball.getPosition().y > lowest->getPosition().y)
+            {
+                lowest = &ball;
+            }
+        }
+        target = lowest->getPosition().x + BALL_RADIUS;
+    }
+    float ballTarget = target;
+
+    // Detour for the soonest wanted bonus if we can still make it back.
+    bool chasingBonus = false;
+    float bestBonusTime = 0;
+    for (const auto &bonus : sim.getBonuses())
+    {
+        Rect bounds = bonus.getBounds();
+        float landing = (paddleTop - (bounds.top + bounds.height)) / BONUS_FALL_SPEED;
+        if (!isWanted(bonus.getType()) || landing < 0)
+        {
+            continue;
+        }
+        float bonusX = bounds.left + bounds.width / 2;
+        float there = std::abs(bonusX - paddleCenter) / speed;
+        float back = std::abs(ballTarget - bonusX) / speed;
+        bool reachable = there <= landing + paddle.getSize().x / 2 / speed;
+        bool safe = !ballComing || landing + back < ballTime;
+        if (reachable && safe && (!chasingBonus || landing < bestBonusTime))
+        {
+            target = bonusX;
+            bestBonusTime = landing;
+            chasingBonus = true;
+        }
+    }
+
+    // Step aside from a shrink bonus about to land, unless a ball needs us here.
+    for (const auto &bonus : sim.getBonuses())
+    {
+        Rect bounds = bonus.getBounds();
+        float landing = (paddleTop - (bounds.top + bounds.height)) / BONUS_FALL_SPEED;
+        float bonusX = bounds.left + bounds.width / 2;
+        bool underIt = std::abs(bonusX - target) < paddle.getSize().x / 2 + bounds.width / 2;
+        if (bonus.getType() != BonusType::ShrinkPaddle || landing < 0 || landing > 0.5f || !underIt)
+        {
+            continue;
+        }
+        if (!ballComing || ballTime > landing + paddle.getSize().x / speed)
+        {
+            float dodge = paddle.getSize().x / 2 + bounds.width;
+            target = bonusX < WINDOW_WIDTH / 2 ? bonusX + dodge : bonusX - dodge;
+        }
+    }
+
+    // Stop within one step of the target instead of jittering around it.
+    float deadband = speed * sim.getDt() / 2;
+    SimInput input;
+    input.left = target < paddleCenter - deadband;
+    input.right = target > paddleCenter + deadband;
+    return input;
+}
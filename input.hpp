@@ -0,0 +1,42 @@
+#pragma once
+
+#include "sim.hpp"
+
+// Where the paddle input for each simulation step comes from: the keyboard
+// in the game, a bot for soak tests and unattended runs.
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+
+    // Called once before every GameSim::step().
+    virtual SimInput next(const GameSim &sim) = 0;
+
+    // Id of the newest input event the last next() reflected, for latency
+    // measurement. Ids count up from 1; sources without events return 0.
+    virtual std::uint64_t getLastEventId() const { return 0; }
+};
+
+// Predictive bot. It works out where the next ball coming down will cross
+// the paddle line, bouncing it off the side walls (bricks are ignored), and
+// moves there. When the ball is far enough away it detours to catch
+// enlarge, fireball and multi-ball bonuses, and it dodges shrink bonuses
+// whenever that does not cost a ball. A non-zero aimError makes it miss by
+// up to that many pixels, rolled once per approaching ball, so it can lose.
+class AutoPlayer : public InputSource
+{
+public:
+    explicit AutoPlayer(float aimError = 0, std::uint64_t seed = 0) : aimError(aimError), rng(seed) {}
+
+    SimInput next(const GameSim &sim) override;
+
+private:
+    // Seconds until the earliest descending ball reaches the paddle, and the
+    // paddle-centre x where it will arrive; false if no ball is coming down.
+    bool predictBall(const GameSim &sim, float &time, float &x) const;
+
+    float aimError;
+    Rng rng;
+    bool ballWasComing = false;
+    float aimOffset = 0;
+};
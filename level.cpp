@@ -0,0 +1,301 @@
+#include "level.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include "brick_grid.hpp"
+
+namespace
+{
+const char LEVEL_MAGIC[4] = {'D', 'X', 'L', 'V'};
+const std::uint32_t LEVEL_VERSION = 2;
+const std::size_t LEVEL_HEADER_SIZE = 16;
+const std::size_t LEVEL_ENTRY_SIZE = 16;
+const std::size_t LEVEL_BYTES_PER_BRICK = 4 * sizeof(std::int16_t) + 2;
+const std::size_t LEVEL_V1_BYTES_PER_BRICK = 4 * sizeof(std::int16_t) + 1;
+
+void putU16(std::vector<std::uint8_t> &out, std::uint16_t value)
+{
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+void putU32(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void putU64(std::vector<std::uint8_t> &out, std::uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+template <typename T>
+T readAt(const std::uint8_t *data, std::size_t offset)
+{
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+bool isValidType(std::uint8_t type)
+{
+    return type <= static_cast<std::uint8_t>(BonusType::MultiBall) || type == static_cast<std::uint8_t>(RANDOM_BONUS);
+}
+
+bool parseCell(char cell, bool &isBrick, BonusType &type, int &hits)
+{
+    isBrick = true;
+    hits = 1;
+    if (cell >= '2' && cell <= '9')
+    {
+        type = BonusType::None;
+        hits = cell - '0';
+        return true;
+    }
+    switch (cell)
+    {
+    case '#':
+        type = BonusType::None;
+        return true;
+    case '?':
+        type = RANDOM_BONUS;
+        return true;
+    case 'E':
+        type = BonusType::EnlargePaddle;
+        return true;
+    case 'S':
+        type = BonusType::ShrinkPaddle;
+        return true;
+    case 'F':
+        type = BonusType::Fireball;
+        return true;
+    case 'M':
+        type = BonusType::MultiBall;
+        return true;
+    case 'X':
+        type = BonusType::None;
+        hits = UNBREAKABLE;
+        return true;
+    case '.':
+    case ' ':
+        isBrick = false;
+        return true;
+    default:
+        return false;
+    }
+}
+}
+
+BonusType rollBonus(Rng &rng, const SimConfig &config)
+{
+    const BonusType kinds[4] = {BonusType::EnlargePaddle, BonusType::ShrinkPaddle, BonusType::Fireball, BonusType::MultiBall};
+    int totalWeight = 0;
+    for (int weight : config.bonusWeights)
+    {
+        totalWeight += weight;
+    }
+    if (config.bonusDropOneIn <= 0 || rng.below(config.bonusDropOneIn) != 0 || totalWeight <= 0)
+    {
+        return BonusType::None;
+    }
+    int pick = rng.below(totalWeight);
+    for (int i = 0; i < 4; ++i)
+    {
+        if (pick < config.bonusWeights[i])
+        {
+            return kinds[i];
+        }
+        pick -= config.bonusWeights[i];
+    }
+    return BonusType::None;
+}
+
+bool parseLevelText(const std::string &path, std::vector<BrickStore> &levels, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    levels.assign(1, BrickStore());
+    int row = 0;
+    int lineNumber = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] == ';')
+        {
+            continue;
+        }
+        if (line == "---")
+        {
+            levels.emplace_back();
+            row = 0;
+            continue;
+        }
+
+        for (std::size_t column = 0; column < line.size(); ++column)
+        {
+            bool isBrick;
+            BonusType type;
+            int hits;
+            if (!parseCell(line[column], isBrick, type, hits))
+            {
+                error = "line " + std::to_string(lineNumber) + ": unknown brick '" + line[column] + "'";
+                return false;
+            }
+            int x = static_cast<int>(column) * (BRICK_WIDTH + 10) + 30;
+            int y = row * (BRICK_HEIGHT + 10) + 30;
+            if (isBrick && (x + BRICK_WIDTH > 32767 || y + BRICK_HEIGHT > 32767))
+            {
+                error = "line " + std::to_string(lineNumber) + ": brick outside the 16-bit coordinate range";
+                return false;
+            }
+            if (isBrick)
+            {
+                levels.back().add(x, y, BRICK_WIDTH, BRICK_HEIGHT, type, hits);
+            }
+        }
+        row++;
+    }
+    return true;
+}
+
+bool writeLevelPack(const std::string &path, const std::vector<BrickStore> &levels)
+{
+    std::vector<std::uint8_t> out(LEVEL_MAGIC, LEVEL_MAGIC + 4);
+    putU32(out, LEVEL_VERSION);
+    putU32(out, levels.size());
+    putU32(out, 0);
+
+    std::vector<std::uint8_t> body;
+    std::size_t bodyStart = LEVEL_HEADER_SIZE + LEVEL_ENTRY_SIZE * levels.size();
+    for (const auto &level : levels)
+    {
+        BrickStore sorted = level;
+        BrickGrid grid;
+        grid.build(sorted);
+
+        while ((bodyStart + body.size()) % 8 != 0)
+        {
+            body.push_back(0);
+        }
+        putU64(out, bodyStart + body.size());
+        putU32(out, sorted.size());
+        putU32(out, 0);
+
+        for (int i = 0; i < sorted.size(); ++i)
+        {
+            putU16(body, static_cast<std::int16_t>(sorted.getBounds(i).left));
+        }
+        for (int i = 0; i < sorted.size(); ++i)
+        {
+            putU16(body, static_cast<std::int16_t>(sorted.getBounds(i).top));
+        }
+        for (int i = 0; i < sorted.size(); ++i)
+        {
+            putU16(body, static_cast<std::int16_t>(sorted.getBounds(i).width));
+        }
+        for (int i = 0; i < sorted.size(); ++i)
+        {
+            putU16(body, static_cast<std::int16_t>(sorted.getBounds(i).height));
+        }
+        for (int i = 0; i < sorted.size(); ++i)
+        {
+            body.push_back(static_cast<std::uint8_t>(sorted.getBonusType(i)));
+        }
+        for (int i = 0; i < sorted.size(); ++i)
+        {
+            body.push_back(static_cast<std::uint8_t>(sorted.getHitPoints(i)));
+        }
+    }
+    out.insert(out.end(), body.begin(), body.end());
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    return static_cast<bool>(file);
+}
+
+bool LevelPack::open(const std::string &path)
+{
+    levels.clear();
+    if (!file.open(path))
+    {
+        return false;
+    }
+    auto fail = [this]()
+    {
+        levels.clear();
+        file.close();
+        return false;
+    };
+    const std::uint8_t *data = file.getData();
+    std::size_t size = file.getSize();
+    std::uint32_t version = size < LEVEL_HEADER_SIZE ? 0 : readAt<std::uint32_t>(data, 4);
+    if (size < LEVEL_HEADER_SIZE || std::memcmp(data, LEVEL_MAGIC, 4) != 0 || version < 1 || version > LEVEL_VERSION)
+    {
+        return fail();
+    }
+    const std::size_t bytesPerBrick = version == 1 ? LEVEL_V1_BYTES_PER_BRICK : LEVEL_BYTES_PER_BRICK;
+    std::uint32_t levelCount = readAt<std::uint32_t>(data, 8);
+    if (levelCount == 0 || levelCount > (size - LEVEL_HEADER_SIZE) / LEVEL_ENTRY_SIZE)
+    {
+        return fail();
+    }
+
+    // Check every brick once here so load() can copy without looking.
+    for (std::uint32_t level = 0; level < levelCount; ++level)
+    {
+        std::size_t entry = LEVEL_HEADER_SIZE + LEVEL_ENTRY_SIZE * level;
+        std::uint64_t offset = readAt<std::uint64_t>(data, entry);
+        std::uint32_t count = readAt<std::uint32_t>(data, entry + 8);
+        if (offset % 8 != 0 || offset > size || count > (size - offset) / bytesPerBrick || count > 0x7FFFFFFF)
+        {
+            return fail();
+        }
+
+        const std::int16_t *columns = reinterpret_cast<const std::int16_t *>(data + offset);
+        const std::uint8_t *types = data + offset + 4 * sizeof(std::int16_t) * count;
+        LevelColumns columnsOf{static_cast<int>(count), columns, columns + count, columns + 2 * count, columns + 3 * count,
+                               types, version == 1 ? nullptr : types + count};
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            if (columnsOf.widths[i] <= 0 || columnsOf.heights[i] <= 0 ||
+                columnsOf.xs[i] + columnsOf.widths[i] > 32767 || columnsOf.ys[i] + columnsOf.heights[i] > 32767 ||
+                !isValidType(columnsOf.types[i]) || (columnsOf.hitPoints && columnsOf.hitPoints[i] == 0))
+            {
+                return fail();
+            }
+        }
+        levels.push_back(columnsOf);
+    }
+    return true;
+}
+
+void LevelPack::load(int level, BrickStore &bricks, Rng &rng, const SimConfig &config) const
+{
+    const LevelColumns &columns = levels[level];
+    bricks.assign(columns.count, columns.xs, columns.ys, columns.widths, columns.heights, columns.types,
+                  columns.hitPoints);
+    for (int i = 0; i < columns.count; ++i)
+    {
+        if (bricks.getBonusType(i) == RANDOM_BONUS)
+        {
+            bricks.setBonusType(i, rollBonus(rng, config));
+        }
+    }
+}
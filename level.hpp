@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "brick_store.hpp"
+#include "mapped_file.hpp"
+#include "random.hpp"
+
+// Only found in level files and parsed layouts: the brick gets a bonus rolled
+// by rollBonus() when the level is loaded, like the built-in levels.
+const BonusType RANDOM_BONUS = static_cast<BonusType>(0xFF);
+
+// One brick in config.bonusDropOneIn hides a bonus (none if it is 0), picked
+// by config.bonusWeights.
+BonusType rollBonus(Rng &rng, const SimConfig &config);
+
+// Text layout, one character per brick cell on the built-in spacing:
+//   '#' brick, '?' brick with a random bonus, 'E' enlarge, 'S' shrink,
+//   'F' fireball, 'M' multi-ball, '2'..'9' brick taking that many hits,
+//   'X' unbreakable brick, '.' or ' ' no brick.
+// Lines starting with ';' are comments and a line "---" starts the next level.
+bool parseLevelText(const std::string &path, std::vector<BrickStore> &levels, std::string &error);
+
+// Level pack file layout (little endian): "DXLV", u32 version, u32 level
+// count, u32 reserved, then per level a u64 offset and u32 brick count plus
+// u32 reserved. At each 8-byte aligned offset the level's bricks follow as
+// columns: i16 x[n], i16 y[n], i16 width[n], i16 height[n], u8 type[n],
+// u8 hitPoints[n]. Version 1 packs have no hit point column.
+// Bricks are written in BrickGrid order so loading needs no sort.
+bool writeLevelPack(const std::string &path, const std::vector<BrickStore> &levels);
+
+// A memory-mapped level pack. open() checks the whole file once; after that
+// load() copies a level's columns straight from the mapping into a BrickStore.
+class LevelPack
+{
+public:
+    bool open(const std::string &path);
+
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+    int getBrickCount(int level) const { return levels[level].count; }
+
+    // Fills bricks with level (0-based) and rolls its random bonuses.
+    void load(int level, BrickStore &bricks, Rng &rng, const SimConfig &config) const;
+
+private:
+    struct LevelColumns
+    {
+        int count;
+        const std::int16_t *xs;
+        const std::int16_t *ys;
+        const std::int16_t *widths;
+        const std::int16_t *heights;
+        const std::uint8_t *types;
+        const std::uint8_t *hitPoints; // null in version 1 packs
+    };
+
+    MappedFile file;
+    std::vector<LevelColumns> levels;
+};
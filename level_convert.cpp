@@ -0,0 +1,52 @@
+// Converts a text level layout (see level.hpp) into a binary level pack, then
+// maps the pack back in and reports how long loading every level takes.
+// Usage: level-convert <layout.txt> <pack.dxl>
+
+#include <chrono>
+#include <iostream>
+
+#include "level.hpp"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: level-convert <layout.txt> <pack.dxl>\n";
+        return 1;
+    }
+
+    std::vector<BrickStore> levels;
+    std::string error;
+    if (!parseLevelText(argv[1], levels, error))
+    {
+        std::cerr << "Error reading " << argv[1] << ": " << error << "\n";
+        return 1;
+    }
+    if (!writeLevelPack(argv[2], levels))
+    {
+        std::cerr << "Error writing " << argv[2] << "\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    LevelPack pack;
+    if (!pack.open(argv[2]))
+    {
+        std::cerr << "Error reading back " << argv[2] << "\n";
+        return 1;
+    }
+    BrickStore bricks;
+    Rng rng(1);
+    long long totalBricks = 0;
+    for (int level = 0; level < pack.getLevelCount(); ++level)
+    {
+        pack.load(level, bricks, rng, SimConfig());
+        totalBricks += bricks.size();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "levels:      " << pack.getLevelCount() << "\n";
+    std::cout << "bricks:      " << totalBricks << "\n";
+    std::cout << "load ms:     " << std::chrono::duration<double, std::milli>(end - start).count() << "\n";
+    return 0;
+}
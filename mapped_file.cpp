@@ -0,0 +1,41 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    data = static_cast<const std::uint8_t *>(mapping);
+    size = info.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data != nullptr)
+    {
+        munmap(const_cast<std::uint8_t *>(data), size);
+        data = nullptr;
+        size = 0;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory map of a whole file.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    const std::uint8_t *getData() const { return data; }
+    std::size_t getSize() const { return size; }
+
+private:
+    const std::uint8_t *data = nullptr;
+    std::size_t size = 0;
+};
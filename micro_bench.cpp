@@ -0,0 +1,327 @@
+// Focused benchmarks for the hot pieces of the game, next to sim-bench's
+// whole-game throughput. Each benchmark runs in batches until a sample has
+// taken SAMPLE_MS; the fastest of SAMPLES samples is reported in ns per
+// operation, since noise only ever makes a sample slower. --json writes the
+// results for other tools; --baseline compares against a file written by
+// --save-baseline and exits with 1 if any benchmark is still slower by more
+// than the tolerance after RETRIES more measurements.
+// Usage: micro-bench [--filter text] [--json file] [--baseline file]
+//                    [--save-baseline file] [--tolerance PERCENT]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "collision.hpp"
+#include "scores.hpp"
+#include "sim.hpp"
+
+const int SAMPLES = 9;
+const double SAMPLE_MS = 40;
+const int RETRIES = 2;
+const int LARGE_SCORE_FILE = 100000; // lines
+
+// One benchmark: run() does a batch of operations and returns how many.
+struct Benchmark
+{
+    std::string name;
+    std::function<long long()> run;
+};
+
+struct Result
+{
+    std::string name;
+    double nsPerOp;
+};
+
+double measure(const Benchmark &benchmark)
+{
+    typedef std::chrono::steady_clock Clock;
+    benchmark.run(); // warm caches and allocations
+    double best = 0;
+    for (int sample = 0; sample < SAMPLES; ++sample)
+    {
+        long long ops = 0;
+        auto start = Clock::now();
+        double elapsed = 0;
+        while (elapsed < SAMPLE_MS)
+        {
+            ops += benchmark.run();
+            elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+        double nsPerOp = elapsed * 1e6 / ops;
+        best = sample == 0 ? nsPerOp : std::min(best, nsPerOp);
+    }
+    return best;
+}
+
+// count bricks on the usual spacing in a roughly square block.
+BrickStore makeField(int count)
+{
+    const int maxColumns = (32767 - 30) / (BRICK_WIDTH + 10);
+    int columns = std::min(maxColumns, static_cast<int>(std::ceil(std::sqrt(count))));
+    BrickStore bricks;
+    for (int i = 0; i < count; ++i)
+    {
+        bricks.add((i % columns) * (BRICK_WIDTH + 10) + 30, (i / columns) * (BRICK_HEIGHT + 10) + 30, BRICK_WIDTH,
+                   BRICK_HEIGHT, BonusType::None);
+    }
+    return bricks;
+}
+
+// The brick half of GameSim::moveBall(): query the grid around one step of
+// ball motion and sweep against every candidate. Balls start at random
+// points of the field, so the cost should not grow with the brick count.
+Benchmark makeBallSweep(int brickCount)
+{
+    struct State
+    {
+        BrickStore bricks;
+        BrickGrid grid;
+        std::vector<Vec2> centers;
+        std::vector<int> candidates;
+    };
+    auto state = std::make_shared<State>();
+    state->bricks = makeField(brickCount);
+    state->grid.build(state->bricks);
+    Rect field = state->bricks.getBounds(0);
+    for (int i = 1; i < state->bricks.size(); ++i)
+    {
+        Rect bounds = state->bricks.getBounds(i);
+        field.width = std::max(field.width, bounds.left + bounds.width - field.left);
+        field.height = std::max(field.height, bounds.top + bounds.height - field.top);
+    }
+    Rng rng(brickCount);
+    for (int i = 0; i < 1024; ++i)
+    {
+        state->centers.push_back({field.left + rng.below(static_cast<std::uint32_t>(field.width)),
+                                  field.top + rng.below(static_cast<std::uint32_t>(field.height))});
+    }
+    return {"ball_sweep/" + std::to_string(brickCount), [state]()
+            {
+                const Vec2 motion = Vec2{BALL_SPEED_X, BALL_SPEED_Y} * (1.0f / 240);
+                int hits = 0;
+                for (Vec2 center : state->centers)
+                {
+                    Rect area{std::min(center.x, center.x + motion.x) - BALL_RADIUS,
+                              std::min(center.y, center.y + motion.y) - BALL_RADIUS,
+                              std::abs(motion.x) + 2 * BALL_RADIUS, std::abs(motion.y) + 2 * BALL_RADIUS};
+                    state->candidates.clear();
+                    state->grid.query(state->bricks, area, state->candidates);
+                    SweepHit hit;
+                    for (int index : state->candidates)
+                    {
+                        hits += sweepCircleRect(center, motion, BALL_RADIUS, state->bricks.getBounds(index), hit);
+                    }
+                }
+                return static_cast<long long>(state->centers.size()) + (hits < 0);
+            }};
+}
+
+std::vector<Benchmark> makeBenchmarks(const std::string &scoresPath)
+{
+    std::vector<Benchmark> benchmarks;
+    for (int count : {50, 1000, 100000})
+    {
+        benchmarks.push_back(makeBallSweep(count));
+    }
+
+    // Bonuses falling out of bricks and being caught or lost, at a steady
+    // population of 100: one op is a spawn plus a removal.
+    auto pool = std::make_shared<BonusPool>();
+    auto churnRng = std::make_shared<Rng>(1);
+    benchmarks.push_back({"bonus_churn", [pool, churnRng]()
+                          {
+                              const int batch = 1000;
+                              while (pool->size() < 100)
+                              {
+                                  pool->spawn(0, 0, BonusType::Fireball);
+                              }
+                              for (int i = 0; i < batch; ++i)
+                              {
+                                  pool->spawn(static_cast<float>(i), 0, BonusType::EnlargePaddle);
+                                  pool->removeAt(static_cast<int>(churnRng->below(pool->size())));
+                              }
+                              return static_cast<long long>(batch);
+                          }});
+
+    auto refillState = std::make_shared<std::pair<BrickStore, BonusPool>>();
+    auto refillRng = std::make_shared<Rng>(1);
+    benchmarks.push_back({"refill_bricks", [refillState, refillRng]()
+                          {
+                              refillBricks(refillState->first, refillState->second, *refillRng, SimConfig());
+                              return 1LL;
+                          }});
+
+    auto grid = std::make_shared<std::pair<BrickStore, BrickGrid>>();
+    benchmarks.push_back({"grid_build/100000", [grid]()
+                          {
+                              grid->first = makeField(100000);
+                              grid->second.build(grid->first);
+                              return 1LL;
+                          }});
+
+    auto sim = std::make_shared<GameSim>(1.0f / 240, 1);
+    auto state = std::make_shared<std::vector<std::uint8_t>>();
+    sim->saveState(*state);
+    benchmarks.push_back({"state_save", [sim, state]()
+                          {
+                              sim->saveState(*state);
+                              return 1LL;
+                          }});
+    benchmarks.push_back({"state_load", [sim, state]()
+                          {
+                              sim->loadState(*state);
+                              return 1LL;
+                          }});
+
+    benchmarks.push_back({"scores_load/" + std::to_string(LARGE_SCORE_FILE), [scoresPath]()
+                          {
+                              return static_cast<long long>(loadScores(scoresPath).size() / LARGE_SCORE_FILE);
+                          }});
+    auto table = std::make_shared<std::vector<Score>>(loadScores(scoresPath));
+    std::string savePath = scoresPath + ".save";
+    benchmarks.push_back({"scores_save/" + std::to_string(LARGE_SCORE_FILE), [table, savePath]()
+                          {
+                              saveScore("BENCH", 1, *table, savePath);
+                              return 1LL;
+                          }});
+    return benchmarks;
+}
+
+bool readBaseline(const std::string &path, std::map<std::string, double> &baseline)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        double nsPerOp;
+        if (!line.empty() && line[0] != '#' && fields >> name >> nsPerOp)
+        {
+            baseline[name] = nsPerOp;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    std::string saveBaselinePath;
+    double tolerance = 50;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter")
+            filter = argv[i + 1];
+        else if (arg == "--json")
+            jsonPath = argv[i + 1];
+        else if (arg == "--baseline")
+            baselinePath = argv[i + 1];
+        else if (arg == "--save-baseline")
+            saveBaselinePath = argv[i + 1];
+        else if (arg == "--tolerance")
+            tolerance = std::atof(argv[i + 1]);
+        else
+            tolerance = -1;
+    }
+    if (argc % 2 == 0 || tolerance < 0)
+    {
+        std::cerr << "Usage: micro-bench [--filter text] [--json file] [--baseline file] [--save-baseline file] "
+                     "[--tolerance PERCENT]\n";
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!baselinePath.empty() && !readBaseline(baselinePath, baseline))
+    {
+        std::cerr << "Cannot read baseline " << baselinePath << "\n";
+        return 1;
+    }
+
+    std::string scoresPath = "/tmp/micro-bench-scores-" + std::to_string(getpid()) + ".txt";
+    {
+        std::ofstream scores(scoresPath);
+        for (int i = 0; i < LARGE_SCORE_FILE; ++i)
+        {
+            scores << "PLAYER" << i << " " << (i * 7919) % 100000 << "\n";
+        }
+    }
+
+    std::vector<Result> results;
+    int regressions = 0;
+    for (const auto &benchmark : makeBenchmarks(scoresPath))
+    {
+        if (benchmark.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        double nsPerOp = measure(benchmark);
+        auto base = baseline.find(benchmark.name);
+        // A slow result has to repeat before it counts.
+        for (int retry = 0; base != baseline.end() && retry < RETRIES && nsPerOp > base->second * (1 + tolerance / 100);
+             ++retry)
+        {
+            nsPerOp = std::min(nsPerOp, measure(benchmark));
+        }
+        results.push_back({benchmark.name, nsPerOp});
+        std::printf("%-22s %14.1f ns/op", benchmark.name.c_str(), nsPerOp);
+        if (base != baseline.end())
+        {
+            double change = 100 * (nsPerOp / base->second - 1);
+            bool regressed = change > tolerance;
+            regressions += regressed;
+            std::printf("  %+7.1f%% vs baseline%s", change, regressed ? "  REGRESSION" : "");
+        }
+        std::printf("\n");
+    }
+    std::remove(scoresPath.c_str());
+    std::remove((scoresPath + ".save").c_str());
+
+    if (!jsonPath.empty())
+    {
+        std::ofstream json(jsonPath);
+        json << "[\n";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            json << "  {\"name\": \"" << results[i].name << "\", \"ns_per_op\": " << results[i].nsPerOp << "}"
+                 << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        json << "]\n";
+    }
+    if (!saveBaselinePath.empty())
+    {
+        std::ofstream file(saveBaselinePath);
+        file << "# micro-bench baseline: name ns_per_op\n";
+        for (const auto &result : results)
+        {
+            file << result.name << " " << result.nsPerOp << "\n";
+        }
+    }
+    if (regressions > 0)
+    {
+        std::cerr << regressions << " benchmark(s) regressed by more than " << tolerance << "%\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+# build and run the subsystem microbenchmarks; fails if one regressed.
+# the first run records this machine's baseline in micro-baseline.txt.
+# extra arguments go to micro-bench, e.g. ./micro_bench.sh --tolerance 30
+SIM_SOURCES="sim.cpp brick_grid.cpp brick_store.cpp collision.cpp replay.cpp profiler.cpp thread_pool.cpp level.cpp mapped_file.cpp bonus_pool.cpp rewind.cpp state_io.cpp"
+
+g++ -O2 $SIM_SOURCES scores.cpp micro_bench.cpp -o micro-bench -pthread -w || exit 1
+if [ ! -f micro-baseline.txt ]
+then
+    ./micro-bench --save-baseline micro-baseline.txt || exit 1
+fi
+./micro-bench --baseline micro-baseline.txt --json micro-bench.json "$@" || exit 1
@@ -0,0 +1,186 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+const int PHASE_COUNT = static_cast<int>(ProfilePhase::Count);
+
+// Cap the trace so a long session cannot exhaust memory; ~40 MB at most.
+const std::size_t MAX_TRACE_EVENTS = 1 << 20;
+const std::size_t MAX_TRACE_FRAMES = 1 << 18;
+}
+
+const char *getPhaseName(ProfilePhase phase)
+{
+    switch (phase)
+    {
+    case ProfilePhase::Events:
+        return "events";
+    case ProfilePhase::Simulation:
+        return "simulation";
+    case ProfilePhase::BallCollision:
+        return "ball+bricks";
+    case ProfilePhase::Bonuses:
+        return "bonuses";
+    case ProfilePhase::Render:
+        return "render";
+    case ProfilePhase::Hud:
+        return "hud";
+    case ProfilePhase::Present:
+        return "present";
+    default:
+        return "?";
+    }
+}
+
+FrameProfiler::FrameProfiler()
+    : origin(Clock::now()), tracing(false), inFrame(false), frameCount(0), current(), phaseStart()
+{
+    history.reserve(HISTORY);
+}
+
+double FrameProfiler::now() const
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - origin).count();
+}
+
+void FrameProfiler::beginFrame()
+{
+    current = FrameRecord();
+    current.start = now();
+    inFrame = true;
+}
+
+void FrameProfiler::endFrame()
+{
+    if (!inFrame)
+    {
+        return;
+    }
+    inFrame = false;
+    current.duration = now() - current.start;
+    if (static_cast<int>(history.size()) < HISTORY)
+    {
+        history.push_back(current);
+    }
+    else
+    {
+        history[frameCount % HISTORY] = current;
+    }
+    if (tracing && frames.size() < MAX_TRACE_FRAMES)
+    {
+        frames.push_back(current);
+    }
+    frameCount++;
+}
+
+void FrameProfiler::begin(ProfilePhase phase)
+{
+    phaseStart[static_cast<int>(phase)] = now();
+}
+
+void FrameProfiler::end(ProfilePhase phase)
+{
+    int index = static_cast<int>(phase);
+    double duration = now() - phaseStart[index];
+    current.phases[index] += duration;
+    if (tracing && events.size() < MAX_TRACE_EVENTS)
+    {
+        events.push_back({phase, phaseStart[index], duration});
+    }
+}
+
+double FrameProfiler::getFramePercentile(double percentile) const
+{
+    if (history.empty())
+    {
+        return 0;
+    }
+    std::vector<double> times;
+    times.reserve(history.size());
+    for (const auto &frame : history)
+    {
+        times.push_back(frame.duration);
+    }
+    std::size_t rank = static_cast<std::size_t>(percentile / 100 * (times.size() - 1) + 0.5);
+    std::nth_element(times.begin(), times.begin() + rank, times.end());
+    return times[rank] / 1000;
+}
+
+double FrameProfiler::getPhaseAverage(ProfilePhase phase) const
+{
+    if (history.empty())
+    {
+        return 0;
+    }
+    double total = 0;
+    for (const auto &frame : history)
+    {
+        total += frame.phases[static_cast<int>(phase)];
+    }
+    return total / history.size() / 1000;
+}
+
+double LatencyRecorder::getPercentile(double percentile) const
+{
+    if (samples.empty())
+    {
+        return 0;
+    }
+    std::vector<double> sorted = samples;
+    std::size_t rank = static_cast<std::size_t>(percentile / 100 * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+bool FrameProfiler::writeChromeTrace(const std::string &path) const
+{
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (const auto &frame : frames)
+    {
+        std::fprintf(file, "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                     first ? "" : ",\n", frame.start, frame.duration);
+        first = false;
+    }
+    for (const auto &event : events)
+    {
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                     first ? "" : ",\n", getPhaseName(event.phase), event.start, event.duration);
+        first = false;
+    }
+    std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return std::fclose(file) == 0;
+}
+
+bool FrameProfiler::writeCsv(const std::string &path) const
+{
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+    std::fprintf(file, "frame,start_us,frame_us");
+    for (int phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        std::fprintf(file, ",%s_us", getPhaseName(static_cast<ProfilePhase>(phase)));
+    }
+    std::fprintf(file, "\n");
+    for (std::size_t i = 0; i < frames.size(); ++i)
+    {
+        std::fprintf(file, "%zu,%.3f,%.3f", i, frames[i].start, frames[i].duration);
+        for (int phase = 0; phase < PHASE_COUNT; ++phase)
+        {
+            std::fprintf(file, ",%.3f", frames[i].phases[phase]);
+        }
+        std::fprintf(file, "\n");
+    }
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ProfilePhase
+{
+    Events,
+    Simulation,
+    BallCollision,
+    Bonuses,
+    Render,
+    Hud,
+    Present,
+    Count
+};
+
+const char *getPhaseName(ProfilePhase phase);
+
+// Lightweight per-frame phase timer. Keeps a rolling window of recent frames
+// for the overlay (frame time percentiles, average cost per phase) and, when
+// tracing, every phase interval for export as a Chrome trace or CSV.
+class FrameProfiler
+{
+public:
+    static const int HISTORY = 512;
+
+    FrameProfiler();
+
+    void setTracing(bool enabled) { tracing = enabled; }
+
+    // beginFrame() again before endFrame() discards the open frame, e.g. to
+    // leave out time spent blocked waiting for input. endFrame() without an
+    // open frame does nothing.
+    void beginFrame();
+    void endFrame();
+
+    void begin(ProfilePhase phase);
+    void end(ProfilePhase phase);
+
+    // Frame time in milliseconds at the given percentile (0-100) over the history.
+    double getFramePercentile(double percentile) const;
+    double getPhaseAverage(ProfilePhase phase) const;
+    int getFrameCount() const { return frameCount; }
+
+    bool writeChromeTrace(const std::string &path) const;
+    bool writeCsv(const std::string &path) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct TraceEvent
+    {
+        ProfilePhase phase;
+        double start; // microseconds since the profiler was created
+        double duration;
+    };
+
+    struct FrameRecord
+    {
+        double start;
+        double duration;
+        double phases[static_cast<int>(ProfilePhase::Count)];
+    };
+
+    double now() const;
+
+    Clock::time_point origin;
+    bool tracing;
+    bool inFrame;
+    int frameCount;
+    FrameRecord current;
+    double phaseStart[static_cast<int>(ProfilePhase::Count)];
+    std::vector<FrameRecord> history;
+    std::vector<FrameRecord> frames;
+    std::vector<TraceEvent> events;
+};
+
+// Input-to-present latencies in milliseconds. Keeps every sample, a few
+// bytes per key event, so the report covers the whole session.
+class LatencyRecorder
+{
+public:
+    void add(double ms) { samples.push_back(ms); }
+    int getCount() const { return static_cast<int>(samples.size()); }
+    double getPercentile(double percentile) const;
+
+private:
+    std::vector<double> samples;
+};
+
+// Times one phase for the lifetime of the scope. A null profiler costs a
+// single branch, so instrumented code can run without one.
+class ScopedPhase
+{
+public:
+    ScopedPhase(FrameProfiler *profiler, ProfilePhase phase) : profiler(profiler), phase(phase)
+    {
+        if (profiler)
+        {
+            profiler->begin(phase);
+        }
+    }
+
+    ~ScopedPhase()
+    {
+        if (profiler)
+        {
+            profiler->end(phase);
+        }
+    }
+
+    ScopedPhase(const ScopedPhase &) = delete;
+    ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+private:
+    FrameProfiler *profiler;
+    ProfilePhase phase;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// Small self-contained PRNG (SplitMix64). Unlike std::rand its sequence is
+// fixed for a given seed on every platform and it carries no hidden global
+// state, so a GameSim can be replayed bit-exactly from its seed.
+class Rng
+{
+public:
+    explicit Rng(std::uint64_t seed = 0) : state(seed) {}
+
+    void seed(std::uint64_t value) { state = value; }
+    std::uint64_t getState() const { return state; }
+
+    std::uint64_t next()
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform integer in [0, bound).
+    std::uint32_t below(std::uint32_t bound)
+    {
+        return static_cast<std::uint32_t>(((next() >> 32) * bound) >> 32);
+    }
+
+private:
+    std::uint64_t state;
+};
@@ -0,0 +1,225 @@
+#include "render.hpp"
+
+namespace
+{
+const int VERTICES_PER_RECT = 6;
+
+void setQuad(sf::Vertex *vertices, const Rect &rect, const sf::FloatRect &region, sf::Color color)
+{
+    sf::Vector2f topLeft(rect.left, rect.top);
+    sf::Vector2f topRight(rect.left + rect.width, rect.top);
+    sf::Vector2f bottomRight(rect.left + rect.width, rect.top + rect.height);
+    sf::Vector2f bottomLeft(rect.left, rect.top + rect.height);
+    sf::Vector2f texTopLeft(region.left, region.top);
+    sf::Vector2f texTopRight(region.left + region.width, region.top);
+    sf::Vector2f texBottomRight(region.left + region.width, region.top + region.height);
+    sf::Vector2f texBottomLeft(region.left, region.top + region.height);
+    vertices[0] = sf::Vertex(topLeft, color, texTopLeft);
+    vertices[1] = sf::Vertex(topRight, color, texTopRight);
+    vertices[2] = sf::Vertex(bottomRight, color, texBottomRight);
+    vertices[3] = sf::Vertex(topLeft, color, texTopLeft);
+    vertices[4] = sf::Vertex(bottomRight, color, texBottomRight);
+    vertices[5] = sf::Vertex(bottomLeft, color, texBottomLeft);
+}
+
+void appendQuad(sf::VertexArray &vertices, const Rect &rect, const sf::FloatRect &region, sf::Color color)
+{
+    std::size_t first = vertices.getVertexCount();
+    vertices.resize(first + VERTICES_PER_RECT);
+    setQuad(&vertices[first], rect, region, color);
+}
+
+Sprite getBonusSprite(BonusType type)
+{
+    switch (type)
+    {
+    case BonusType::EnlargePaddle:
+        return Sprite::BonusEnlarge;
+    case BonusType::ShrinkPaddle:
+        return Sprite::BonusShrink;
+    case BonusType::Fireball:
+        return Sprite::BonusFireball;
+    default:
+        return Sprite::BonusMultiBall;
+    }
+}
+
+// The paddle sprite matching its current width; bonuses only ever move it
+// between the three configured widths.
+Sprite getPaddleSprite(float width)
+{
+    if (width > PADDLE_WIDTH)
+        return Sprite::PaddleEnlarged;
+    if (width < PADDLE_WIDTH)
+        return Sprite::PaddleShrunken;
+    return Sprite::Paddle;
+}
+}
+
+sf::Color getColorForBonusType(BonusType type)
+{
+    switch (type)
+    {
+    case BonusType::EnlargePaddle:
+        return sf::Color::Yellow;
+    case BonusType::ShrinkPaddle:
+        return sf::Color::Magenta;
+    case BonusType::Fireball:
+        return sf::Color::Cyan;
+    case BonusType::MultiBall:
+        return sf::Color(255, 128, 0);
+    default:
+        return sf::Color::White;
+    }
+}
+
+sf::Color getColorForBrick(int hitPoints)
+{
+    switch (hitPoints)
+    {
+    case UNBREAKABLE:
+        return sf::Color(170, 170, 185);
+    case 1:
+        return sf::Color::Blue;
+    case 2:
+        return sf::Color(110, 60, 230);
+    case 3:
+        return sf::Color(190, 50, 200);
+    default:
+        return sf::Color(230, 40, 90);
+    }
+}
+
+BatchRenderer::BatchRenderer()
+    : brickBuffer(sf::Triangles, sf::VertexBuffer::Dynamic), dynamicVertices(sf::Triangles), layoutVersion(0),
+      bufferReady(false)
+{
+}
+
+void BatchRenderer::setBrickQuad(const FrameSnapshot &snapshot, int i)
+{
+    const BrickStore &bricks = *snapshot.brickLayout;
+    bool alive = snapshot.isBrickAlive(i);
+    int hitPoints = alive ? snapshot.getBrickHitPoints(i) : 0;
+    Sprite sprite = Sprite::Brick;
+    if (hitPoints == UNBREAKABLE)
+    {
+        sprite = Sprite::BrickUnbreakable;
+    }
+    else if (hitPoints < bricks.getInitialHitPoints(i))
+    {
+        sprite = Sprite::BrickDamaged;
+    }
+    setQuad(&brickVertices[i * VERTICES_PER_RECT], alive ? bricks.getBounds(i) : Rect{0, 0, 0, 0},
+            atlas.getRegion(sprite), getColorForBrick(hitPoints));
+}
+
+void BatchRenderer::syncBricks(const FrameSnapshot &snapshot)
+{
+    const BrickStore &bricks = *snapshot.brickLayout;
+    if (layoutVersion != snapshot.brickLayoutVersion)
+    {
+        brickVertices.resize(bricks.size() * VERTICES_PER_RECT);
+        for (int i = 0; i < bricks.size(); ++i)
+        {
+            setBrickQuad(snapshot, i);
+        }
+        layoutVersion = snapshot.brickLayoutVersion;
+        renderedAlive = snapshot.aliveBricks;
+        renderedDamage = snapshot.damagedBricks;
+        bufferReady = !brickVertices.empty() && brickBuffer.create(brickVertices.size()) &&
+                      brickBuffer.update(brickVertices.data());
+        return;
+    }
+
+    // Bricks that died since the last frame collapse to zero-area quads and
+    // any a rewind brought back are restored; comparing 64 bricks per word
+    // skips the untouched stretches quickly.
+    dirtyBricks.clear();
+    for (std::size_t word = 0; word < renderedAlive.size(); ++word)
+    {
+        std::uint64_t changed = renderedAlive[word] ^ snapshot.aliveBricks[word];
+        for (; changed != 0; changed &= changed - 1)
+        {
+            dirtyBricks.push_back(static_cast<int>(word * 64 + __builtin_ctzll(changed)));
+        }
+        renderedAlive[word] = snapshot.aliveBricks[word];
+    }
+
+    // Both damage lists are sorted by index; walk them together for bricks
+    // whose hit points changed.
+    const std::vector<BrickHitPoints> &damage = snapshot.damagedBricks;
+    std::size_t from = 0;
+    std::size_t to = 0;
+    while (from < renderedDamage.size() || to < damage.size())
+    {
+        if (to == damage.size() || (from < renderedDamage.size() && renderedDamage[from].index < damage[to].index))
+        {
+            dirtyBricks.push_back(renderedDamage[from++].index);
+        }
+        else if (from == renderedDamage.size() || damage[to].index < renderedDamage[from].index)
+        {
+            dirtyBricks.push_back(damage[to++].index);
+        }
+        else
+        {
+            if (renderedDamage[from].hitPoints != damage[to].hitPoints)
+            {
+                dirtyBricks.push_back(damage[to].index);
+            }
+            from++;
+            to++;
+        }
+    }
+    renderedDamage = damage;
+
+    // Rewrite only the dirty quads in the GPU buffer; the rest of the field
+    // stays where it was uploaded.
+    for (int i : dirtyBricks)
+    {
+        setBrickQuad(snapshot, i);
+        if (bufferReady)
+        {
+            brickBuffer.update(&brickVertices[i * VERTICES_PER_RECT], VERTICES_PER_RECT, i * VERTICES_PER_RECT);
+        }
+    }
+}
+
+void BatchRenderer::draw(sf::RenderTarget &target, const FrameSnapshot &snapshot, float alpha)
+{
+    syncBricks(snapshot);
+
+    dynamicVertices.clear();
+    const Paddle &paddle = snapshot.paddle;
+    Vec2 paddlePosition = paddle.getPosition(alpha);
+    appendQuad(dynamicVertices, Rect{paddlePosition.x, paddlePosition.y, paddle.getSize().x, paddle.getSize().y},
+               atlas.getRegion(getPaddleSprite(paddle.getSize().x)), sf::Color::Green);
+
+    for (const auto &ball : snapshot.balls)
+    {
+        Vec2 ballPosition = ball.getPosition(alpha);
+        bool fireball = ball.isFireballActive();
+        appendQuad(dynamicVertices, Rect{ballPosition.x, ballPosition.y, 2 * BALL_RADIUS, 2 * BALL_RADIUS},
+                   atlas.getRegion(fireball ? Sprite::Fireball : Sprite::Ball), fireball ? sf::Color::Yellow : sf::Color::Red);
+    }
+
+    for (const auto &bonus : snapshot.bonuses)
+    {
+        Vec2 position = bonus.getPosition(alpha);
+        Rect bounds = bonus.getBounds();
+        appendQuad(dynamicVertices, Rect{position.x, position.y, bounds.width, bounds.height},
+                   atlas.getRegion(getBonusSprite(bonus.getType())), getColorForBonusType(bonus.getType()));
+    }
+
+    // Both layers sample the same atlas, so the texture stays bound between them.
+    sf::RenderStates states(&atlas.getTexture());
+    if (bufferReady)
+    {
+        target.draw(brickBuffer, states);
+    }
+    else if (!brickVertices.empty())
+    {
+        target.draw(brickVertices.data(), brickVertices.size(), sf::Triangles, states);
+    }
+    target.draw(dynamicVertices, states);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "sim_thread.hpp"
+#include "sprite_atlas.hpp"
+
+sf::Color getColorForBonusType(BonusType type);
+// Tint for a brick with that many hit points left.
+sf::Color getColorForBrick(int hitPoints);
+
+// Draws the playfield as textured quads from one SpriteAtlas in two batched
+// calls. The brick layer lives in a GPU vertex buffer; each frame only the
+// quads of bricks that died, came back or changed hit points since the last
+// drawn snapshot are rewritten, unless a new layout was loaded. Without
+// vertex buffer support the same quads are drawn from memory.
+// Paddle, balls and bonuses move every frame and share one small dynamic layer.
+class BatchRenderer
+{
+public:
+    BatchRenderer();
+
+    void draw(sf::RenderTarget &target, const FrameSnapshot &snapshot, float alpha);
+
+private:
+    void syncBricks(const FrameSnapshot &snapshot);
+    void setBrickQuad(const FrameSnapshot &snapshot, int i);
+
+    SpriteAtlas atlas;
+    std::vector<sf::Vertex> brickVertices;
+    sf::VertexBuffer brickBuffer;
+    sf::VertexArray dynamicVertices;
+    unsigned layoutVersion;
+    bool bufferReady;
+    std::vector<std::uint64_t> renderedAlive;
+    std::vector<BrickHitPoints> renderedDamage;
+    std::vector<int> dirtyBricks;
+};
@@ -0,0 +1,171 @@
+#include "replay.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+const char REPLAY_MAGIC[4] = {'D', 'X', 'R', 'P'};
+const std::uint32_t REPLAY_VERSION = 3; // 2: multi-ball bonus, 3: pooled bonus order
+
+void putU32(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+void putU64(std::vector<std::uint8_t> &out, std::uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+void putVarint(std::vector<std::uint8_t> &out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+class Reader
+{
+public:
+    Reader(const std::vector<std::uint8_t> &data) : data(data), offset(0) {}
+
+    bool getU32(std::uint32_t &value) { return getBytes(value, 4); }
+    bool getU64(std::uint64_t &value) { return getBytes(value, 8); }
+
+    bool getU8(std::uint8_t &value)
+    {
+        if (offset >= data.size())
+        {
+            return false;
+        }
+        value = data[offset++];
+        return true;
+    }
+
+    bool getVarint(std::uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            std::uint8_t byte;
+            if (!getU8(byte))
+            {
+                return false;
+            }
+            value |= std::uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool atEnd() const { return offset == data.size(); }
+
+private:
+    template <typename T>
+    bool getBytes(T &value, int count)
+    {
+        if (data.size() - offset < static_cast<std::size_t>(count))
+        {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            value |= T(data[offset++]) << (8 * i);
+        }
+        return true;
+    }
+
+    const std::vector<std::uint8_t> &data;
+    std::size_t offset;
+};
+}
+
+std::uint8_t packInput(const SimInput &input)
+{
+    return (input.left ? 1 : 0) | (input.right ? 2 : 0);
+}
+
+SimInput unpackInput(std::uint8_t bits)
+{
+    SimInput input;
+    input.left = bits & 1;
+    input.right = bits & 2;
+    return input;
+}
+
+bool saveReplay(const Replay &replay, const std::string &path)
+{
+    std::vector<std::uint8_t> out(REPLAY_MAGIC, REPLAY_MAGIC + 4);
+    putU32(out, REPLAY_VERSION);
+    putU32(out, replay.simHz);
+    putU64(out, replay.seed);
+    putU64(out, replay.inputs.size());
+    putU64(out, replay.finalChecksum);
+    for (std::size_t i = 0; i < replay.inputs.size();)
+    {
+        std::size_t run = 1;
+        while (i + run < replay.inputs.size() && replay.inputs[i + run] == replay.inputs[i])
+        {
+            run++;
+        }
+        out.push_back(replay.inputs[i]);
+        putVarint(out, run);
+        i += run;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    return static_cast<bool>(file);
+}
+
+bool loadReplay(const std::string &path, Replay &replay)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 4 || std::memcmp(data.data(), REPLAY_MAGIC, 4) != 0)
+    {
+        return false;
+    }
+
+    Reader reader(data);
+    std::uint32_t magic, version;
+    std::uint64_t ticks;
+    if (!reader.getU32(magic) || !reader.getU32(version) || version != REPLAY_VERSION ||
+        !reader.getU32(replay.simHz) || !reader.getU64(replay.seed) || !reader.getU64(ticks) ||
+        !reader.getU64(replay.finalChecksum))
+    {
+        return false;
+    }
+
+    replay.inputs.clear();
+    while (replay.inputs.size() < ticks)
+    {
+        std::uint8_t bits;
+        std::uint64_t run;
+        if (!reader.getU8(bits) || !reader.getVarint(run) || run > ticks - replay.inputs.size())
+        {
+            return false;
+        }
+        replay.inputs.insert(replay.inputs.end(), run, bits);
+    }
+    return reader.atEnd() && replay.simHz > 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sim.hpp"
+
+// One recorded game: the step rate, the seed passed to GameSim::reset() and
+// the input of every step. Stepping a fresh GameSim with these reproduces
+// the game exactly, which finalChecksum lets playback verify.
+//
+// File layout (little endian): "DXRP", u32 version, u32 simHz, u64 seed,
+// u64 tick count, u64 final checksum, then the inputs run-length encoded as
+// (u8 input bits, varint run length) pairs.
+struct Replay
+{
+    std::uint32_t simHz = 0;
+    std::uint64_t seed = 0;
+    std::vector<std::uint8_t> inputs;
+    std::uint64_t finalChecksum = 0;
+};
+
+std::uint8_t packInput(const SimInput &input);
+SimInput unpackInput(std::uint8_t bits);
+
+bool saveReplay(const Replay &replay, const std::string &path);
+bool loadReplay(const std::string &path, Replay &replay);
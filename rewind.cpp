@@ -0,0 +1,125 @@
+#include "rewind.hpp"
+
+#include <cstring>
+
+#include "state_io.hpp"
+
+RewindBuffer::RewindBuffer(std::size_t budgetBytes) : ring(budgetBytes)
+{
+}
+
+void RewindBuffer::clear()
+{
+    entries.clear();
+    newest.clear();
+}
+
+std::size_t RewindBuffer::getBytesUsed() const
+{
+    std::size_t used = 0;
+    for (const auto &entry : entries)
+    {
+        used += entry.size;
+    }
+    return used;
+}
+
+void RewindBuffer::push(const GameSim &sim)
+{
+    sim.saveState(scratch);
+    int sinceKeyframe = 0;
+    for (auto entry = entries.rbegin(); entry != entries.rend() && !entry->keyframe; ++entry)
+    {
+        sinceKeyframe++;
+    }
+    bool keyframe = entries.empty() || sinceKeyframe + 1 >= KEYFRAME_INTERVAL || scratch.size() != newest.size();
+    if (!keyframe)
+    {
+        encodeStateDelta(newest, scratch, delta);
+        keyframe = !store(delta, false);
+    }
+    if (keyframe)
+    {
+        store(scratch, true);
+    }
+    newest.swap(scratch);
+}
+
+// Entries never wrap around the end of the ring, which keeps decoding a
+// straight read; the tail that does not fit an entry is left unused.
+bool RewindBuffer::store(const std::vector<std::uint8_t> &bytes, bool keyframe)
+{
+    if (bytes.size() > ring.size())
+    {
+        entries.clear();
+        return keyframe;
+    }
+    std::size_t offset = entries.empty() ? 0 : entries.back().offset + entries.back().size;
+    if (offset + bytes.size() > ring.size())
+    {
+        // Wrap; anything still stored past the newest entry is older than
+        // everything before it.
+        while (!entries.empty() && entries.front().offset >= offset)
+        {
+            entries.pop_front();
+        }
+        offset = 0;
+    }
+    auto overlaps = [&](const Entry &entry)
+    { return entry.offset < offset + bytes.size() && offset < entry.offset + entry.size; };
+    while (!entries.empty() && overlaps(entries.front()))
+    {
+        entries.pop_front();
+    }
+    // A delta is useless without the keyframe it counts from.
+    while (!entries.empty() && !entries.front().keyframe)
+    {
+        entries.pop_front();
+    }
+    if (!keyframe && entries.empty())
+    {
+        return false;
+    }
+    if (!bytes.empty())
+    {
+        std::memcpy(ring.data() + offset, bytes.data(), bytes.size());
+    }
+    entries.push_back({offset, bytes.size(), keyframe});
+    return true;
+}
+
+// Rebuilds newest from the latest keyframe after the newest entry changed.
+void RewindBuffer::decodeNewest()
+{
+    std::size_t first = entries.size() - 1;
+    while (!entries[first].keyframe)
+    {
+        first--;
+    }
+    const Entry &keyframe = entries[first];
+    newest.assign(ring.begin() + keyframe.offset, ring.begin() + keyframe.offset + keyframe.size);
+    for (std::size_t i = first + 1; i < entries.size(); ++i)
+    {
+        applyStateDelta(ring.data() + entries[i].offset, entries[i].size, newest);
+    }
+}
+
+bool RewindBuffer::stepBack(GameSim &sim)
+{
+    if (entries.size() < 2)
+    {
+        return false;
+    }
+    // XOR is its own inverse, so a delta undoes itself in place.
+    Entry dropped = entries.back();
+    entries.pop_back();
+    if (dropped.keyframe)
+    {
+        decodeNewest();
+    }
+    else
+    {
+        applyStateDelta(ring.data() + dropped.offset, dropped.size, newest);
+    }
+    return sim.loadState(newest);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "sim.hpp"
+
+// Recent GameSim states in a fixed byte budget, newest last, for stepping a
+// game backwards. Most states are stored as the XOR against the one before
+// with zero runs collapsed, so a tick where little moved costs tens of bytes.
+// Every KEYFRAME_INTERVAL-th state, and any state whose size changed, is
+// stored whole so decoding never walks far. The oldest states are dropped to
+// make room.
+class RewindBuffer
+{
+public:
+    static const int KEYFRAME_INTERVAL = 64;
+
+    explicit RewindBuffer(std::size_t budgetBytes);
+
+    void clear();
+
+    // Appends the sim's current state.
+    void push(const GameSim &sim);
+
+    // Drops the newest state and loads the one before it into sim. False,
+    // changing nothing, when no older state is held.
+    bool stepBack(GameSim &sim);
+
+    int getCount() const { return static_cast<int>(entries.size()); }
+    std::size_t getBytesUsed() const;
+
+private:
+    struct Entry
+    {
+        std::size_t offset;
+        std::size_t size;
+        bool keyframe;
+    };
+
+    bool store(const std::vector<std::uint8_t> &bytes, bool keyframe);
+    void decodeNewest();
+
+    std::vector<std::uint8_t> ring;
+    std::deque<Entry> entries;
+    std::vector<std::uint8_t> newest; // full state of entries.back()
+    std::vector<std::uint8_t> scratch;
+    std::vector<std::uint8_t> delta;
+};
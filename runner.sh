@@ -1,4 +1,23 @@
 # compile *.cpp files sfml. ignore warnings
-g++ -c game.cpp -w
-g++ game.o -o sfml-app -lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio -lsfml-network
-./sfml-app
\ No newline at end of file
+# headless simulation core, shared by the game and the command line tools
+SIM_SOURCES="sim.cpp brick_grid.cpp brick_store.cpp collision.cpp replay.cpp profiler.cpp thread_pool.cpp level.cpp mapped_file.cpp bonus_pool.cpp rewind.cpp state_io.cpp"
+SIM_OBJECTS="sim.o brick_grid.o brick_store.o collision.o replay.o profiler.o thread_pool.o level.o mapped_file.o bonus_pool.o rewind.o state_io.o"
+
+g++ -O2 -c game.cpp render.cpp scores.cpp audio.cpp asset_pack.cpp hud.cpp input.cpp sim_thread.cpp spectator.cpp sprite_atlas.cpp $SIM_SOURCES -w
+g++ game.o render.o scores.o audio.o asset_pack.o hud.o input.o sim_thread.o spectator.o sprite_atlas.o $SIM_OBJECTS -o sfml-app -pthread -lsfml-graphics -lsfml-window -lsfml-system -lsfml-audio -lsfml-network
+# headless simulation benchmark, does not need SFML
+g++ -O2 $SIM_SOURCES sim_bench.cpp -o sim-bench -pthread -w
+# headless replay playback: ./sim-replay game.dxr
+g++ -O2 $SIM_SOURCES sim_replay.cpp -o sim-replay -pthread -w
+# autoplayer soak test: ./sim-soak 3600
+g++ -O2 $SIM_SOURCES input.cpp sim_soak.cpp -o sim-soak -pthread -w
+# balance testing: ./sim-batch 100000 --sweep paddle-width=150,200,250
+g++ -O2 $SIM_SOURCES input.cpp sim_batch.cpp -o sim-batch -pthread -w
+# text layout to binary level pack: ./level-convert levels.txt levels.dxl
+g++ -O2 $SIM_SOURCES level_convert.cpp -o level-convert -pthread -w
+# spectator streaming over localhost: ./spectate-test 30 --viewers 4 --loss 5
+g++ -O2 $SIM_SOURCES input.cpp sim_thread.cpp spectator.cpp spectate_test.cpp -o spectate-test -pthread -lsfml-network -lsfml-system -w
+# font and sounds packed into the single file the game maps at startup
+g++ -O2 asset_pack.cpp mapped_file.cpp asset_pack_tool.cpp -o asset-pack -w
+./asset-pack assets.pak Font/gomarice_no_continue.ttf music/hit.ogg music/yeah.ogg
+./sfml-app
@@ -0,0 +1,141 @@
+#include "scores.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <unistd.h>
+
+std::vector<Score> loadScores(const std::string &path)
+{
+    std::vector<Score> high_scores;
+    std::ifstream file(path);
+    if (file.is_open())
+    {
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream ss(line);
+            Score score;
+            if (ss >> score.name >> score.score)
+            {
+                high_scores.push_back(score);
+            }
+        }
+        file.close();
+    }
+    return high_scores;
+}
+
+bool isHighScore(int score, const std::vector<Score> &high_scores)
+{
+    if (high_scores.size() < MAX_HIGH_SCORES)
+    {
+        return true;
+    }
+    for (const auto &s : high_scores)
+    {
+        if (score > s.score)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void insertScore(std::vector<Score> &high_scores, const std::string &name, int score)
+{
+    high_scores.push_back({name, score});
+    if (high_scores.size() > MAX_HIGH_SCORES)
+    {
+        high_scores.erase(std::min_element(high_scores.begin(), high_scores.end(), [](const Score &a, const Score &b)
+                                           { return a.score < b.score; }));
+    }
+    std::sort(high_scores.begin(), high_scores.end(), [](const Score &a, const Score &b)
+              { return a.score > b.score; });
+}
+
+bool writeScores(const std::vector<Score> &high_scores, const std::string &path)
+{
+    std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = true;
+    for (const auto &s : high_scores)
+    {
+        ok = ok && std::fprintf(file, "%s %d\n", s.name.c_str(), s.score) > 0;
+    }
+    ok = ok && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void saveScore(const std::string &name, int score, std::vector<Score> high_scores, const std::string &path)
+{
+    insertScore(high_scores, name, score);
+    writeScores(high_scores, path);
+}
+
+ScoreStore::ScoreStore(const std::string &path)
+    : path(path), scores(loadScores(path)), version(0), hasPending(false), stopping(false)
+{
+    writer = std::thread(&ScoreStore::writerLoop, this);
+}
+
+ScoreStore::~ScoreStore()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+void ScoreStore::add(const std::string &name, int score)
+{
+    insertScore(scores, name, score);
+    version++;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = scores;
+        hasPending = true;
+    }
+    wake.notify_one();
+}
+
+void ScoreStore::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this]
+                  { return hasPending || stopping; });
+        if (hasPending)
+        {
+            std::vector<Score> table;
+            table.swap(pending);
+            hasPending = false;
+            lock.unlock();
+            if (!writeScores(table, path))
+            {
+                std::cerr << "Error saving high scores to " << path << "\n";
+            }
+            lock.lock();
+        }
+        else if (stopping)
+        {
+            return;
+        }
+    }
+}
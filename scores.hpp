@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int MAX_HIGH_SCORES = 5;
+
+class Score
+{
+public:
+    std::string name;
+    int score;
+};
+
+std::vector<Score> loadScores(const std::string &path = "high_scores.txt");
+bool isHighScore(int score, const std::vector<Score> &high_scores);
+
+// Adds the entry, keeps the best MAX_HIGH_SCORES and sorts them best first.
+void insertScore(std::vector<Score> &high_scores, const std::string &name, int score);
+
+// Writes to a temporary file next to path and renames it over path, so a
+// crash mid-write never leaves a truncated table behind.
+bool writeScores(const std::vector<Score> &high_scores, const std::string &path = "high_scores.txt");
+
+void saveScore(const std::string &name, int score, std::vector<Score> high_scores, const std::string &path = "high_scores.txt");
+
+// High-score table read once at startup and kept in memory. Changes are
+// persisted by a background thread so the UI never waits on the disk; if
+// several changes pile up only the latest table is written.
+class ScoreStore
+{
+public:
+    explicit ScoreStore(const std::string &path);
+    ~ScoreStore();
+
+    ScoreStore(const ScoreStore &) = delete;
+    ScoreStore &operator=(const ScoreStore &) = delete;
+
+    const std::vector<Score> &getScores() const { return scores; }
+
+    // Bumped on every change, so callers can cache anything built from the table.
+    unsigned getVersion() const { return version; }
+
+    bool isHighScore(int score) const { return ::isHighScore(score, scores); }
+    void add(const std::string &name, int score);
+
+private:
+    void writerLoop();
+
+    std::string path;
+    std::vector<Score> scores;
+    unsigned version;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<Score> pending;
+    bool hasPending;
+    bool stopping;
+    std::thread writer;
+};
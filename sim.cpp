@@ -0,0 +1,585 @@
+#include "sim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "collision.hpp"
+#include "state_io.hpp"
+
+namespace
+{
+const std::uint32_t STATE_MAGIC = 0x54535844; // "DXST"
+}
+
+void refillBricks(BrickStore &bricks, BonusPool &bonuses, Rng &rng, const SimConfig &config)
+{
+    bricks.clear();
+    bonuses.clear();
+    for (int i = 0; i < BRICK_ROWS; ++i)
+    {
+        for (int j = 0; j < BRICKS_PER_ROW; ++j)
+        {
+            BonusType bonusType = rollBonus(rng, config);
+            bricks.add(j * (BRICK_WIDTH + 10) + 30, i * (BRICK_HEIGHT + 10) + 30, BRICK_WIDTH, BRICK_HEIGHT, bonusType);
+        }
+    }
+}
+
+GameSim::GameSim(float dt, std::uint64_t seed, const SimConfig &config)
+    : dt(dt), config(config),
+      paddle(WINDOW_WIDTH / 2 - config.paddleWidth / 2, WINDOW_HEIGHT - PADDLE_HEIGHT - 10, config.paddleWidth)
+{
+    reset(seed);
+}
+
+void GameSim::reset(std::uint64_t newSeed)
+{
+    seed = newSeed;
+    rng.seed(seed);
+    tick = 0;
+    level = 1;
+    lives = config.lives;
+    score = 0;
+    finished = false;
+    bonusTimer = 0;
+    isBonusActive = false;
+    activeBonusType = BonusType::None;
+    resetBallAndPaddle();
+    loadBricks();
+}
+
+void GameSim::loadBricks()
+{
+    if (levelPack)
+    {
+        levelPack->load(level - 1, bricks, rng, config);
+        bonuses.clear();
+    }
+    else
+    {
+        refillBricks(bricks, bonuses, rng, config);
+    }
+    brickGrid.build(bricks);
+    brickLayoutVersion++;
+    resetBrickChanges();
+}
+
+void GameSim::resetBrickChanges()
+{
+    brickChanges.clear();
+    brickStateVersion++;
+}
+
+namespace
+{
+// FNV-1a over raw bytes; floats are hashed by bit pattern so any drift shows.
+class StateHash
+{
+public:
+    template <typename T>
+    void add(const T &value)
+    {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        for (unsigned char byte : bytes)
+        {
+            hash = (hash ^ byte) * 0x100000001B3ull;
+        }
+    }
+
+    std::uint64_t get() const { return hash; }
+
+private:
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+};
+}
+
+std::uint64_t GameSim::checksum() const
+{
+    StateHash hash;
+    hash.add(rng.getState());
+    hash.add(level);
+    hash.add(lives);
+    hash.add(score);
+    hash.add(finished);
+    hash.add(bonusTimer);
+    hash.add(isBonusActive);
+    hash.add(activeBonusType);
+    hash.add(paddle.getPosition());
+    hash.add(paddle.getSize());
+    hash.add(balls.size());
+    for (const auto &ball : balls)
+    {
+        hash.add(ball.getPosition());
+        hash.add(ball.getVelocity());
+        hash.add(ball.isFireballActive());
+    }
+    hash.add(bricks.getAliveCount());
+    for (int i = 0; i < bricks.size(); ++i)
+    {
+        hash.add(bricks.isAlive(i));
+        // Single-hit bricks hash as they always did, so older replays verify.
+        if (bricks.getHitPoints(i) > 1)
+        {
+            hash.add(bricks.getHitPoints(i));
+        }
+    }
+    for (const auto &bonus : bonuses)
+    {
+        hash.add(bonus.getBounds());
+        hash.add(bonus.getType());
+    }
+    return hash.get();
+}
+
+void GameSim::saveState(std::vector<std::uint8_t> &out) const
+{
+    // Fixed-size fields first, so consecutive states line up byte for byte
+    // for RewindBuffer's delta encoding.
+    out.clear();
+    StateWriter writer(out);
+    writer.add(STATE_MAGIC);
+    writer.add(seed);
+    writer.add(rng.getState());
+    writer.add(tick);
+    writer.add(level);
+    writer.add(lives);
+    writer.add(score);
+    writer.add(finished);
+    writer.add(bonusTimer);
+    writer.add(isBonusActive);
+    writer.add(activeBonusType);
+    writer.add(paddle);
+    writer.addArray(balls);
+    bonuses.save(writer);
+    bricks.save(writer);
+}
+
+bool GameSim::loadState(const std::vector<std::uint8_t> &state)
+{
+    StateReader reader(state.data(), state.size());
+    std::uint32_t magic = 0;
+    std::uint64_t loadedSeed = 0;
+    std::uint64_t rngState = 0;
+    std::uint64_t loadedTick = 0;
+    int loadedLevel = 0;
+    int loadedLives = 0;
+    int loadedScore = 0;
+    bool loadedFinished = false;
+    float loadedBonusTimer = 0;
+    bool loadedBonusActive = false;
+    BonusType loadedBonusType = BonusType::None;
+    Paddle loadedPaddle(0, 0);
+    std::vector<Ball> loadedBalls;
+    reader.read(magic);
+    reader.read(loadedSeed);
+    reader.read(rngState);
+    reader.read(loadedTick);
+    reader.read(loadedLevel);
+    reader.read(loadedLives);
+    reader.read(loadedScore);
+    reader.read(loadedFinished);
+    reader.read(loadedBonusTimer);
+    reader.read(loadedBonusActive);
+    reader.read(loadedBonusType);
+    reader.read(loadedPaddle);
+    reader.readArray(loadedBalls, MAX_BALLS, Ball(0, 0));
+    if (!reader.isValid() || magic != STATE_MAGIC || loadedLevel < 1)
+    {
+        return false;
+    }
+
+    std::vector<Bonus> loadedBonuses;
+    reader.readArray(loadedBonuses, bonuses.getCapacity(), Bonus(0, 0, BonusType::None));
+    BrickStore loadedBricks;
+    if (!loadedBricks.load(reader) || !reader.isAtEnd())
+    {
+        return false;
+    }
+
+    seed = loadedSeed;
+    rng.seed(rngState);
+    tick = loadedTick;
+    level = loadedLevel;
+    lives = loadedLives;
+    score = loadedScore;
+    finished = loadedFinished;
+    bonusTimer = loadedBonusTimer;
+    isBonusActive = loadedBonusActive;
+    activeBonusType = loadedBonusType;
+    paddle = loadedPaddle;
+    balls.swap(loadedBalls);
+    bonuses.assign(loadedBonuses);
+    if (!bricks.hasSameLayout(loadedBricks))
+    {
+        brickLayoutVersion++;
+    }
+    bricks = std::move(loadedBricks);
+    brickGrid.build(bricks);
+    resetBrickChanges();
+    return true;
+}
+
+void GameSim::resetBallAndPaddle()
+{
+    paddle = Paddle(WINDOW_WIDTH / 2 - config.paddleWidth / 2, WINDOW_HEIGHT - PADDLE_HEIGHT - 10, config.paddleWidth);
+    serveBalls();
+}
+
+void GameSim::setStressBalls(int count)
+{
+    stressBalls = std::max(0, std::min(count, MAX_BALLS));
+    serveBalls();
+}
+
+void GameSim::serveBalls()
+{
+    balls.clear();
+    if (stressBalls == 0)
+    {
+        balls.emplace_back(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS, config.ballVelocity);
+        return;
+    }
+
+    // Fan the stress balls out over 120 degrees around straight up.
+    const float speed = std::sqrt(dot(config.ballVelocity, config.ballVelocity));
+    for (int i = 0; i < stressBalls; ++i)
+    {
+        float angle = ((i + 0.5f) / stressBalls - 0.5f) * 2.0943951f;
+        Ball ball(WINDOW_WIDTH / 2 - BALL_RADIUS, WINDOW_HEIGHT / 2 - BALL_RADIUS);
+        ball.setVelocity({speed * std::sin(angle), -speed * std::cos(angle)});
+        balls.push_back(ball);
+    }
+}
+
+// Every ball in play splits into itself plus two copies turned +-30 degrees.
+void GameSim::splitBalls()
+{
+    std::size_t count = balls.size();
+    for (std::size_t i = 0; i < count && balls.size() + 2 <= MAX_BALLS; ++i)
+    {
+        Ball left = balls[i];
+        Ball right = balls[i];
+        left.setVelocity(rotate(balls[i].getVelocity(), MULTI_BALL_SPLIT_COS, -MULTI_BALL_SPLIT_SIN));
+        right.setVelocity(rotate(balls[i].getVelocity(), MULTI_BALL_SPLIT_COS, MULTI_BALL_SPLIT_SIN));
+        balls.push_back(left);
+        balls.push_back(right);
+    }
+}
+
+void GameSim::applyBonus(BonusType type)
+{
+    // Multi-ball is instant and leaves any timed bonus running.
+    if (type == BonusType::MultiBall)
+    {
+        splitBalls();
+        return;
+    }
+
+    if (type == BonusType::EnlargePaddle)
+    {
+        paddle.setWidth(config.paddleEnlargedWidth);
+    }
+    else if (type == BonusType::ShrinkPaddle)
+    {
+        paddle.setWidth(config.paddleShrunkenWidth);
+    }
+    else if (type == BonusType::Fireball)
+    {
+        for (auto &ball : balls)
+        {
+            ball.activateFireball();
+        }
+    }
+    activeBonusType = type;
+    isBonusActive = true;
+    bonusTimer = config.bonusDuration;
+}
+
+void GameSim::damageBrick(const BrickHit &hit, StepResult &result)
+{
+    int index = hit.brick;
+    if (!bricks.isBreakable(index))
+    {
+        return;
+    }
+    if (brickChanges.size() >= static_cast<std::size_t>(bricks.size()))
+    {
+        resetBrickChanges();
+    }
+    brickChanges.push_back(index);
+    if (!hit.smash && bricks.damage(index) > 0)
+    {
+        return;
+    }
+
+    Rect bounds = bricks.getBounds(index);
+    if (bricks.getBonusType(index) != BonusType::None)
+    {
+        bonuses.spawn(bounds.left + bounds.width / 2, bounds.top + bounds.height / 2, bricks.getBonusType(index));
+    }
+    bricks.destroy(index);
+    result.bricksHit++;
+    score++;
+}
+
+// Moves every ball in two phases. First each ball sweeps against the bricks
+// as they were at the start of the step and records what it hit; balls do not
+// see each other's hits, so they can be moved in parallel chunks. Then the
+// hits are applied in ball order: each hit takes one hit point, and a brick
+// broken by an earlier ball in the same step ignores the rest. The outcome is
+// the same for any thread count.
+void GameSim::moveBalls(StepResult &result)
+{
+    ScopedPhase phase(profiler, ProfilePhase::BallCollision);
+    int count = static_cast<int>(balls.size());
+    bool parallel = threadPool != nullptr && threadPool->getThreadCount() > 1 && count >= PARALLEL_BALL_THRESHOLD;
+    int chunkSize = parallel ? BALLS_PER_CHUNK : count;
+    int chunks = parallel ? (count + chunkSize - 1) / chunkSize : 1;
+    if (static_cast<int>(ballWork.size()) < chunks)
+    {
+        ballWork.resize(chunks);
+    }
+
+    auto moveChunk = [&](int chunk)
+    {
+        BallWork &work = ballWork[chunk];
+        work.hits.clear();
+        int last = std::min(count, (chunk + 1) * chunkSize);
+        for (int i = chunk * chunkSize; i < last; ++i)
+        {
+            moveBall(balls[i], work);
+        }
+    };
+    if (parallel)
+    {
+        threadPool->run(chunks, moveChunk);
+    }
+    else
+    {
+        moveChunk(0);
+    }
+
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        for (const BrickHit &hit : ballWork[chunk].hits)
+        {
+            if (bricks.isAlive(hit.brick))
+            {
+                damageBrick(hit, result);
+            }
+        }
+    }
+}
+
+// Moves one ball through the step one contact at a time: find the earliest
+// time of impact against walls, paddle and nearby bricks, advance to it,
+// respond, and sweep the rest of the motion. A brick this ball already hit
+// during the step is ignored, so the ball can neither tunnel nor double-bounce.
+// If the iteration budget runs out the ball rests at its last contact until
+// the next step.
+void GameSim::moveBall(Ball &ball, BallWork &work) const
+{
+    const float radius = BALL_RADIUS;
+    const std::size_t firstHit = work.hits.size();
+    float remaining = 1;
+    for (int iteration = 0; iteration < MAX_COLLISION_ITERATIONS && remaining > 0; ++iteration)
+    {
+        Vec2 center = ball.getCenter();
+        Vec2 motion = ball.getVelocity() * (dt * remaining);
+
+        SweepHit best{1, {0, 0}};
+        bool hasHit = false;
+        int hitBrick = -1;
+
+        if (motion.x < 0 && center.x + motion.x < radius)
+        {
+            best = {std::max(0.0f, (radius - center.x) / motion.x), {1, 0}};
+            hasHit = true;
+        }
+        else if (motion.x > 0 && center.x + motion.x > WINDOW_WIDTH - radius)
+        {
+            best = {std::max(0.0f, (WINDOW_WIDTH - radius - center.x) / motion.x), {-1, 0}};
+            hasHit = true;
+        }
+        if (motion.y < 0 && center.y + motion.y < radius)
+        {
+            float time = std::max(0.0f, (radius - center.y) / motion.y);
+            if (!hasHit || time < best.time)
+            {
+                best = {time, {0, 1}};
+                hasHit = true;
+            }
+        }
+        else if (stressBalls > 0 && motion.y > 0 && center.y + motion.y > WINDOW_HEIGHT - radius)
+        {
+            float time = std::max(0.0f, (WINDOW_HEIGHT - radius - center.y) / motion.y);
+            if (!hasHit || time < best.time)
+            {
+                best = {time, {0, -1}};
+                hasHit = true;
+            }
+        }
+
+        SweepHit hit;
+        if (sweepCircleRect(center, motion, radius, paddle.getBounds(), hit) && (!hasHit || hit.time < best.time))
+        {
+            best = hit;
+            hasHit = true;
+        }
+
+        Rect start = ball.getBounds();
+        Rect swept{std::min(start.left, start.left + motion.x) - 1, std::min(start.top, start.top + motion.y) - 1,
+                   start.width + std::abs(motion.x) + 2, start.height + std::abs(motion.y) + 2};
+        work.candidates.clear();
+        brickGrid.query(bricks, swept, work.candidates);
+        for (int index : work.candidates)
+        {
+            if (std::any_of(work.hits.begin() + firstHit, work.hits.end(),
+                            [index](const BrickHit &earlier) { return earlier.brick == index; }))
+            {
+                continue;
+            }
+            if (sweepCircleRect(center, motion, radius, bricks.getBounds(index), hit) && (!hasHit || hit.time < best.time))
+            {
+                best = hit;
+                hasHit = true;
+                hitBrick = index;
+            }
+        }
+
+        if (!hasHit)
+        {
+            ball.setPosition(ball.getPosition().x + motion.x, ball.getPosition().y + motion.y);
+            break;
+        }
+
+        ball.setPosition(ball.getPosition().x + motion.x * best.time, ball.getPosition().y + motion.y * best.time);
+        remaining *= 1 - best.time;
+        if (hitBrick >= 0)
+        {
+            // Fireballs go straight through anything they can break.
+            bool smash = ball.isFireballActive() && bricks.isBreakable(hitBrick);
+            work.hits.push_back({hitBrick, smash});
+            if (smash)
+            {
+                continue;
+            }
+        }
+        ball.setVelocity(reflect(ball.getVelocity(), best.normal));
+    }
+
+    // The paddle may have moved into the ball rather than the other way round.
+    if (ball.getVelocity().y > 0 && ball.getBounds().intersects(paddle.getBounds()))
+    {
+        ball.bounce();
+        ball.setPosition(ball.getBounds().left, paddle.getBounds().top - BALL_RADIUS * 2);
+    }
+}
+
+void GameSim::updateBonuses()
+{
+    ScopedPhase phase(profiler, ProfilePhase::Bonuses);
+    for (int i = 0; i < bonuses.size();)
+    {
+        Bonus &bonus = bonuses[i];
+        bonus.update(dt);
+        if (bonus.getBounds().intersects(paddle.getBounds()))
+        {
+            applyBonus(bonus.getType());
+            bonuses.removeAt(i);
+        }
+        else if (bonus.getBounds().top > WINDOW_HEIGHT)
+        {
+            bonuses.removeAt(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+StepResult GameSim::step(const SimInput &input)
+{
+    StepResult result;
+    if (finished)
+    {
+        return result;
+    }
+    ScopedPhase phase(profiler, ProfilePhase::Simulation);
+    tick++;
+
+    paddle.storePrevious();
+    for (auto &ball : balls)
+    {
+        ball.storePrevious();
+    }
+
+    if (input.left)
+    {
+        paddle.move(-config.paddleSpeed * dt);
+    }
+    else if (input.right)
+    {
+        paddle.move(config.paddleSpeed * dt);
+    }
+
+    moveBalls(result);
+
+    updateBonuses();
+
+    if (isBonusActive)
+    {
+        bonusTimer -= dt;
+        if (bonusTimer <= 0)
+        {
+            paddle.setWidth(config.paddleWidth);
+            for (auto &ball : balls)
+            {
+                ball.deactivateFireball();
+            }
+            isBonusActive = false;
+            activeBonusType = BonusType::None;
+        }
+    }
+
+    // Balls that fall off the bottom are gone; the life goes with the last one.
+    balls.erase(std::remove_if(balls.begin(), balls.end(),
+                               [](const Ball &ball) { return ball.getBounds().top + BALL_RADIUS * 2 > WINDOW_HEIGHT; }),
+                balls.end());
+    if (balls.empty())
+    {
+        lives--;
+        result.lifeLost = true;
+        if (lives > 0)
+        {
+            serveBalls();
+        }
+        else
+        {
+            finished = true;
+            result.gameFinished = true;
+            return result;
+        }
+    }
+
+    if (bricks.getBreakableCount() == 0)
+    {
+        result.levelCleared = true;
+        if (level < getLevelCount())
+        {
+            level++;
+            loadBricks();
+            resetBallAndPaddle();
+        }
+        else
+        {
+            finished = true;
+            result.gameFinished = true;
+        }
+    }
+
+    return result;
+}
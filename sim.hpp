@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bonus_pool.hpp"
+#include "brick_grid.hpp"
+#include "brick_store.hpp"
+#include "level.hpp"
+#include "profiler.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+#include "sim_types.hpp"
+
+// Headless game simulation. Nothing in here depends on SFML so the core can be
+// stepped on machines without a window (see sim_bench.cpp).
+
+class Paddle
+{
+public:
+    Paddle(float startX, float startY, float width = PADDLE_WIDTH)
+        : position{startX, startY}, previousPosition(position), size{width, PADDLE_HEIGHT}
+    {
+    }
+
+    void storePrevious() { previousPosition = position; }
+
+    void move(float dx)
+    {
+        position.x += dx;
+        if (position.x < 0)
+        {
+            position.x = 0;
+        }
+        else if (position.x + size.x > WINDOW_WIDTH)
+        {
+            position.x = WINDOW_WIDTH - size.x;
+        }
+    }
+
+    void setWidth(float width) { size.x = width; }
+
+    Vec2 getPosition() const { return position; }
+    Vec2 getPosition(float alpha) const { return lerp(previousPosition, position, alpha); }
+    Vec2 getSize() const { return size; }
+    Rect getBounds() const { return {position.x, position.y, size.x, size.y}; }
+
+private:
+    Vec2 position;
+    Vec2 previousPosition;
+    Vec2 size;
+};
+
+class Ball
+{
+public:
+    Ball(float startX, float startY, Vec2 startVelocity = {BALL_SPEED_X, BALL_SPEED_Y})
+        : position{startX, startY}, previousPosition(position), velocity(startVelocity), fireballActive(false)
+    {
+    }
+
+    void storePrevious() { previousPosition = position; }
+
+    void bounce() { velocity.y = -velocity.y; }
+
+    void setPosition(float x, float y) { position = {x, y}; }
+    void setVelocity(Vec2 newVelocity) { velocity = newVelocity; }
+    Vec2 getPosition() const { return position; }
+    Vec2 getPosition(float alpha) const { return lerp(previousPosition, position, alpha); }
+    Vec2 getCenter() const { return {position.x + BALL_RADIUS, position.y + BALL_RADIUS}; }
+    Vec2 getVelocity() const { return velocity; }
+    Rect getBounds() const { return {position.x, position.y, BALL_RADIUS * 2, BALL_RADIUS * 2}; }
+
+    void activateFireball() { fireballActive = true; }
+    void deactivateFireball() { fireballActive = false; }
+    bool isFireballActive() const { return fireballActive; }
+
+private:
+    Vec2 position;
+    Vec2 previousPosition;
+    Vec2 velocity;
+    bool fireballActive;
+};
+
+struct SimInput
+{
+    bool left;
+    bool right;
+};
+
+// What happened during one GameSim::step(), for the frontend to react to.
+struct StepResult
+{
+    int bricksHit = 0;
+    bool lifeLost = false;
+    bool levelCleared = false;
+    bool gameFinished = false;
+};
+
+void refillBricks(BrickStore &bricks, BonusPool &bonuses, Rng &rng, const SimConfig &config);
+
+class GameSim
+{
+public:
+    GameSim(float dt, std::uint64_t seed, const SimConfig &config = SimConfig());
+
+    // Start a new game on level 1. The seed fixes every random choice in the
+    // game, so the same seed and inputs always produce the same game.
+    void reset(std::uint64_t seed);
+
+    // Advance the simulation by one fixed step of getDt() seconds.
+    StepResult step(const SimInput &input);
+
+    // Optional; with a pool, steps with many balls move them in parallel.
+    // Results do not depend on whether or how many threads are used.
+    void setThreadPool(ThreadPool *pool) { threadPool = pool; }
+
+    // Optional; levels come from the pack instead of the built-in random
+    // layouts, starting with the next reset(). The pack must outlive the sim.
+    void setLevelPack(const LevelPack *pack) { levelPack = pack; }
+
+    // Stress mode: every serve launches count balls instead of one, and the
+    // bottom edge bounces balls back instead of swallowing them.
+    void setStressBalls(int count);
+
+    // Optional; when set, step() reports its phases to the profiler.
+    void setProfiler(FrameProfiler *frameProfiler) { profiler = frameProfiler; }
+
+    // Hash of the whole simulation state, for checking replays.
+    std::uint64_t checksum() const;
+
+    // Compact binary copy of the game in progress, for quick-saves and
+    // rewinding; out is overwritten. loadState() restores one into a sim with
+    // the same dt and config, keeping its thread pool, level pack, profiler
+    // and stress setting. It returns false, changing nothing, on a malformed
+    // state. The brick layout version only changes if the bricks' positions
+    // or types differ, so a renderer keeps its layout across a rewind.
+    void saveState(std::vector<std::uint8_t> &out) const;
+    bool loadState(const std::vector<std::uint8_t> &state);
+
+    float getDt() const { return dt; }
+    const SimConfig &getConfig() const { return config; }
+    std::uint64_t getSeed() const { return seed; }
+    std::uint64_t getTick() const { return tick; } // steps since reset()
+    int getLevel() const { return level; }
+    int getLevelCount() const { return levelPack ? levelPack->getLevelCount() : BUILTIN_LEVELS; }
+    int getLives() const { return lives; }
+    int getScore() const { return score; }
+    bool isFinished() const { return finished; }
+    BonusType getActiveBonusType() const { return activeBonusType; }
+    const Paddle &getPaddle() const { return paddle; }
+    const std::vector<Ball> &getBalls() const { return balls; }
+    int getBricksRemaining() const { return bricks.getBreakableCount(); }
+
+    // Includes destroyed bricks; check BrickStore::isAlive().
+    const BrickStore &getBricks() const { return bricks; }
+
+    // Bumped whenever a new brick layout is loaded.
+    unsigned getBrickLayoutVersion() const { return brickLayoutVersion; }
+
+    // Bricks that lost hit points, in order, since the brick state version
+    // last changed. The version changes whenever bricks change some other way
+    // (new layout, loaded state) or the list grows past the brick count, so a
+    // reader that remembers the version and how far it read can follow every
+    // change without scanning the whole field.
+    const std::vector<int> &getBrickChanges() const { return brickChanges; }
+    unsigned getBrickStateVersion() const { return brickStateVersion; }
+
+    const BonusPool &getBonuses() const { return bonuses; }
+
+private:
+    void resetBallAndPaddle();
+    void loadBricks();
+    void applyBonus(BonusType type);
+    // A fireball smashes any breakable brick in one hit.
+    struct BrickHit
+    {
+        int brick;
+        bool smash;
+    };
+
+    // Per-chunk scratch for moving balls; hits are in the order the chunk's
+    // balls reached them.
+    struct alignas(64) BallWork
+    {
+        std::vector<int> candidates;
+        std::vector<BrickHit> hits;
+    };
+
+    void serveBalls();
+    void splitBalls();
+    void moveBalls(StepResult &result);
+    void moveBall(Ball &ball, BallWork &work) const;
+    void updateBonuses();
+    void damageBrick(const BrickHit &hit, StepResult &result);
+    void resetBrickChanges();
+
+    float dt;
+    SimConfig config;
+    FrameProfiler *profiler = nullptr;
+    ThreadPool *threadPool = nullptr;
+    const LevelPack *levelPack = nullptr;
+    int stressBalls = 0;
+    std::uint64_t seed;
+    Rng rng;
+    std::uint64_t tick;
+    int level;
+    int lives;
+    int score;
+    bool finished;
+    float bonusTimer;
+    bool isBonusActive;
+    BonusType activeBonusType;
+    Paddle paddle;
+    std::vector<Ball> balls;
+    std::vector<BallWork> ballWork;
+    BrickStore bricks;
+    BrickGrid brickGrid;
+    unsigned brickLayoutVersion = 0;
+    std::vector<int> brickChanges;
+    unsigned brickStateVersion = 0;
+    BonusPool bonuses;
+};
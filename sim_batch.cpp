@@ -0,0 +1,268 @@
+// Plays many seeded games with the AutoPlayer across all cores and reports
+// score, lives lost and level duration distributions, for comparing balance
+// changes. Every --sweep multiplies the configurations that get played;
+// --set changes a value for all of them.
+// Usage: sim-batch [games] [--threads N] [--seed S] [--sim-hz N] [--aim-error PX]
+//                  [--set name=value] [--sweep name=v1,v2,...]
+// --aim-error makes the bot miss by up to PX pixels so that lives get lost.
+// Names: drop-one-in, weight-enlarge, weight-shrink, weight-fireball,
+// weight-multiball, bonus-duration, paddle-width, paddle-enlarged,
+// paddle-shrunken, paddle-speed, ball-speed-x, ball-speed-y, lives.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "input.hpp"
+#include "sim.hpp"
+#include "thread_pool.hpp"
+
+const int GAMES_PER_CHUNK = 64;
+const double MAX_GAME_SECONDS = 1200; // simulated; longer games are cut off and counted as timeouts
+
+bool setConfigValue(SimConfig &config, const std::string &name, double value)
+{
+    if (name == "drop-one-in")
+        config.bonusDropOneIn = static_cast<int>(value);
+    else if (name == "weight-enlarge")
+        config.bonusWeights[0] = static_cast<int>(value);
+    else if (name == "weight-shrink")
+        config.bonusWeights[1] = static_cast<int>(value);
+    else if (name == "weight-fireball")
+        config.bonusWeights[2] = static_cast<int>(value);
+    else if (name == "weight-multiball")
+        config.bonusWeights[3] = static_cast<int>(value);
+    else if (name == "bonus-duration")
+        config.bonusDuration = static_cast<float>(value);
+    else if (name == "paddle-width")
+        config.paddleWidth = static_cast<float>(value);
+    else if (name == "paddle-enlarged")
+        config.paddleEnlargedWidth = static_cast<float>(value);
+    else if (name == "paddle-shrunken")
+        config.paddleShrunkenWidth = static_cast<float>(value);
+    else if (name == "paddle-speed")
+        config.paddleSpeed = static_cast<float>(value);
+    else if (name == "ball-speed-x")
+        config.ballVelocity.x = static_cast<float>(value);
+    else if (name == "ball-speed-y")
+        config.ballVelocity.y = static_cast<float>(value);
+    else if (name == "lives")
+        config.lives = static_cast<int>(value);
+    else
+        return false;
+    return true;
+}
+
+struct Sweep
+{
+    std::string name;
+    std::vector<double> values;
+};
+
+// Outcomes of a run of games; chunks fill their own and are merged in order.
+struct BatchStats
+{
+    long long wins = 0;
+    long long timeouts = 0;
+    std::vector<int> scores;
+    std::vector<int> livesLost;
+    std::vector<std::vector<float>> levelSeconds;
+
+    void merge(const BatchStats &other)
+    {
+        wins += other.wins;
+        timeouts += other.timeouts;
+        scores.insert(scores.end(), other.scores.begin(), other.scores.end());
+        livesLost.insert(livesLost.end(), other.livesLost.begin(), other.livesLost.end());
+        levelSeconds.resize(std::max(levelSeconds.size(), other.levelSeconds.size()));
+        for (std::size_t level = 0; level < other.levelSeconds.size(); ++level)
+        {
+            levelSeconds[level].insert(levelSeconds[level].end(), other.levelSeconds[level].begin(),
+                                       other.levelSeconds[level].end());
+        }
+    }
+};
+
+void playGames(GameSim &sim, std::uint64_t firstSeed, int count, float aimError, BatchStats &stats)
+{
+    stats.levelSeconds.resize(sim.getLevelCount());
+    const long long maxTicks = static_cast<long long>(MAX_GAME_SECONDS / sim.getDt());
+    for (int game = 0; game < count; ++game)
+    {
+        sim.reset(firstSeed + game);
+        AutoPlayer player(aimError, firstSeed + game);
+        long long ticks = 0;
+        long long levelStart = 0;
+        while (!sim.isFinished() && ticks < maxTicks)
+        {
+            int level = sim.getLevel();
+            StepResult result = sim.step(player.next(sim));
+            ticks++;
+            if (result.levelCleared)
+            {
+                stats.levelSeconds[level - 1].push_back((ticks - levelStart) * sim.getDt());
+                levelStart = ticks;
+            }
+        }
+        if (!sim.isFinished())
+        {
+            stats.timeouts++;
+        }
+        else if (sim.getLives() > 0)
+        {
+            stats.wins++;
+        }
+        stats.scores.push_back(sim.getScore());
+        stats.livesLost.push_back(sim.getConfig().lives - sim.getLives());
+    }
+}
+
+template <typename T>
+void printDistribution(const char *label, std::vector<T> values)
+{
+    if (values.empty())
+    {
+        std::printf("  %-12s no samples\n", label);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (T value : values)
+    {
+        sum += value;
+    }
+    auto percentile = [&](double p) { return static_cast<double>(values[static_cast<std::size_t>(p / 100 * (values.size() - 1))]); };
+    std::printf("  %-12s n %-8zu mean %8.2f  p10 %8.2f  p50 %8.2f  p90 %8.2f  max %8.2f\n", label, values.size(),
+                sum / values.size(), percentile(10), percentile(50), percentile(90), percentile(100));
+}
+
+int main(int argc, char *argv[])
+{
+    long long games = 10000;
+    int threads = 0;
+    std::uint64_t seed = 1;
+    int simHz = 240;
+    float aimError = 0;
+    SimConfig baseConfig;
+    std::vector<Sweep> sweeps;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string value = i + 1 < argc ? argv[i + 1] : "";
+        std::size_t equals = value.find('=');
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--aim-error" && i + 1 < argc)
+        {
+            aimError = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (arg == "--sim-hz" && i + 1 < argc)
+        {
+            simHz = std::atoi(argv[++i]);
+        }
+        else if (arg == "--set" && equals != std::string::npos)
+        {
+            if (!setConfigValue(baseConfig, value.substr(0, equals), std::atof(value.c_str() + equals + 1)))
+            {
+                std::cerr << "Unknown parameter " << value.substr(0, equals) << "\n";
+                return 1;
+            }
+            i++;
+        }
+        else if (arg == "--sweep" && equals != std::string::npos)
+        {
+            Sweep sweep{value.substr(0, equals), {}};
+            std::stringstream list(value.substr(equals + 1));
+            std::string item;
+            while (std::getline(list, item, ','))
+            {
+                sweep.values.push_back(std::atof(item.c_str()));
+            }
+            SimConfig probe;
+            if (sweep.values.empty() || !setConfigValue(probe, sweep.name, 0))
+            {
+                std::cerr << "Bad sweep " << value << "\n";
+                return 1;
+            }
+            sweeps.push_back(sweep);
+            i++;
+        }
+        else
+        {
+            games = std::atoll(argv[i]);
+        }
+    }
+    if (games <= 0 || simHz <= 0 || threads < 0 || aimError < 0)
+    {
+        std::cerr << "Usage: sim-batch [games] [--threads N] [--seed S] [--sim-hz N] [--aim-error PX] "
+                     "[--set name=value] [--sweep name=v1,v2,...]\n";
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    std::cout << "games per config: " << games << ", threads: " << pool.getThreadCount() << ", sim hz: " << simHz << "\n";
+
+    // Walk every combination of sweep values like an odometer.
+    std::vector<std::size_t> choice(sweeps.size(), 0);
+    while (true)
+    {
+        SimConfig config = baseConfig;
+        std::ostringstream label;
+        for (std::size_t s = 0; s < sweeps.size(); ++s)
+        {
+            setConfigValue(config, sweeps[s].name, sweeps[s].values[choice[s]]);
+            label << sweeps[s].name << "=" << sweeps[s].values[choice[s]] << " ";
+        }
+
+        int chunks = static_cast<int>((games + GAMES_PER_CHUNK - 1) / GAMES_PER_CHUNK);
+        std::vector<BatchStats> chunkStats(chunks);
+        auto start = std::chrono::steady_clock::now();
+        pool.run(chunks, [&](int chunk)
+                 {
+                     long long first = static_cast<long long>(chunk) * GAMES_PER_CHUNK;
+                     int count = static_cast<int>(std::min<long long>(GAMES_PER_CHUNK, games - first));
+                     GameSim sim(1.0f / simHz, seed, config);
+                     playGames(sim, seed + first, count, aimError, chunkStats[chunk]);
+                 });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        BatchStats stats;
+        for (const auto &chunk : chunkStats)
+        {
+            stats.merge(chunk);
+        }
+
+        std::printf("\nconfig: %s\n", sweeps.empty() ? "default" : label.str().c_str());
+        std::printf("  wins %.1f%%  timeouts %lld  %.2f s  %.0f games/s\n", 100.0 * stats.wins / games, stats.timeouts,
+                    seconds, games / seconds);
+        printDistribution("score", stats.scores);
+        printDistribution("lives lost", stats.livesLost);
+        for (std::size_t level = 0; level < stats.levelSeconds.size(); ++level)
+        {
+            std::string name = "level " + std::to_string(level + 1) + " s";
+            printDistribution(name.c_str(), stats.levelSeconds[level]);
+        }
+
+        std::size_t s = 0;
+        while (s < sweeps.size() && ++choice[s] == sweeps[s].values.size())
+        {
+            choice[s++] = 0;
+        }
+        if (s == sweeps.size())
+        {
+            break;
+        }
+    }
+    return 0;
+}
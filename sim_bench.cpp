@@ -0,0 +1,154 @@
+// Steps the headless GameSim as fast as possible and reports ticks per second.
+// Usage: sim-bench [ticks] [sim-hz] [--balls N] [--threads N] [--levels pack] [--rewind MB]
+// --balls runs the stress mode with N balls per serve; --threads sets the
+// thread count for moving them (default 1, 0 = one per core); --levels plays
+// a level pack instead of the built-in layouts; --rewind pushes every step
+// into a rewind buffer of that size and reports what the states cost.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "rewind.hpp"
+#include "sim.hpp"
+
+// Keep the paddle under the lowest ball so games last long enough to exercise
+// the brick and bonus loops instead of just losing lives.
+SimInput trackBall(const GameSim &sim)
+{
+    const Ball *lowest = &sim.getBalls().front();
+    for (const auto &ball : sim.getBalls())
+    {
+        if (ball.getPosition().y > lowest->getPosition().y)
+        {
+            lowest = &ball;
+        }
+    }
+    float ballCenter = lowest->getPosition().x + BALL_RADIUS;
+    float paddleCenter = sim.getPaddle().getPosition().x + sim.getPaddle().getSize().x / 2;
+    SimInput input;
+    input.left = ballCenter < paddleCenter - 5;
+    input.right = ballCenter > paddleCenter + 5;
+    return input;
+}
+
+int main(int argc, char *argv[])
+{
+    long long ticks = 5000000;
+    int simHz = 240;
+    int ballCount = 0;
+    int threads = 1;
+    std::string levelsPath;
+    int rewindMb = 0;
+    int positional = 0;
+    bool valid = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--balls" || arg == "--threads") && i + 1 < argc)
+        {
+            (arg == "--balls" ? ballCount : threads) = std::atoi(argv[++i]);
+        }
+        else if (arg == "--rewind" && i + 1 < argc)
+        {
+            rewindMb = std::atoi(argv[++i]);
+        }
+        else if (arg == "--levels" && i + 1 < argc)
+        {
+            levelsPath = argv[++i];
+        }
+        else if (positional == 0)
+        {
+            ticks = std::atoll(argv[i]);
+            positional++;
+        }
+        else if (positional == 1)
+        {
+            simHz = std::atoi(argv[i]);
+            positional++;
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+    if (!valid || ticks <= 0 || simHz <= 0 || ballCount < 0 || threads < 0 || rewindMb < 0)
+    {
+        std::cerr << "Usage: sim-bench [ticks] [sim-hz] [--balls N] [--threads N] [--levels pack] [--rewind MB]\n";
+        return 1;
+    }
+
+    LevelPack levelPack;
+    if (!levelsPath.empty() && !levelPack.open(levelsPath))
+    {
+        std::cerr << "Error loading level pack " << levelsPath << "\n";
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    GameSim sim(1.0f / simHz, 1);
+    sim.setThreadPool(&pool);
+    sim.setStressBalls(ballCount);
+    if (!levelsPath.empty())
+    {
+        sim.setLevelPack(&levelPack);
+        sim.reset(sim.getSeed());
+    }
+
+    RewindBuffer rewind(static_cast<std::size_t>(rewindMb) << 20);
+    long long games = 0;
+    long long bricksHit = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < ticks; ++i)
+    {
+        StepResult result = sim.step(trackBall(sim));
+        bricksHit += result.bricksHit;
+        if (rewindMb > 0)
+        {
+            rewind.push(sim);
+        }
+        if (result.gameFinished)
+        {
+            games++;
+            sim.reset(sim.getSeed() + 1);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "ticks:       " << ticks << "\n";
+    std::cout << "sim hz:      " << simHz << "\n";
+    std::cout << "threads:     " << pool.getThreadCount() << "\n";
+    std::cout << "games:       " << games << "\n";
+    std::cout << "bricks hit:  " << bricksHit << "\n";
+    std::cout << "checksum:    " << std::hex << sim.checksum() << std::dec << "\n";
+    std::cout << "seconds:     " << seconds << "\n";
+    std::cout << "ticks/s:     " << static_cast<long long>(ticks / seconds) << "\n";
+
+    if (rewindMb > 0)
+    {
+        // Time a save and a restore of the final state on a separate sim.
+        const int rounds = 10000;
+        std::vector<std::uint8_t> state;
+        GameSim restored = sim;
+        auto saveStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i)
+        {
+            sim.saveState(state);
+        }
+        auto loadStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i)
+        {
+            restored.loadState(state);
+        }
+        auto loadEnd = std::chrono::steady_clock::now();
+        std::cout << "state bytes: " << state.size() << "\n";
+        std::cout << "save us:     " << std::chrono::duration<double, std::micro>(loadStart - saveStart).count() / rounds << "\n";
+        std::cout << "load us:     " << std::chrono::duration<double, std::micro>(loadEnd - loadStart).count() / rounds << "\n";
+        std::cout << "rewind held: " << rewind.getCount() << " steps\n";
+        std::cout << "step bytes:  " << rewind.getBytesUsed() / std::max(1, rewind.getCount()) << "\n";
+    }
+    return 0;
+}
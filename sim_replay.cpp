@@ -0,0 +1,56 @@
+// Plays a recorded game headlessly, as fast as possible, and checks that the
+// final state matches the recording bit for bit.
+// Usage: sim-replay <replay-file> [repeat]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "replay.hpp"
+#include "sim.hpp"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: sim-replay <replay-file> [repeat]\n";
+        return 1;
+    }
+    int repeat = argc > 2 ? std::atoi(argv[2]) : 1;
+
+    Replay replay;
+    if (!loadReplay(argv[1], replay))
+    {
+        std::cerr << "Error loading replay " << argv[1] << "\n";
+        return 1;
+    }
+
+    GameSim sim(1.0f / replay.simHz, replay.seed);
+    std::uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+        sim.reset(replay.seed);
+        for (std::uint8_t bits : replay.inputs)
+        {
+            sim.step(unpackInput(bits));
+        }
+        checksum = sim.checksum();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double ticks = static_cast<double>(replay.inputs.size()) * repeat;
+    std::cout << "ticks:       " << replay.inputs.size() << " x " << repeat << "\n";
+    std::cout << "sim hz:      " << replay.simHz << "\n";
+    std::cout << "score:       " << sim.getScore() << "\n";
+    std::cout << "seconds:     " << seconds << "\n";
+    std::cout << "ticks/s:     " << static_cast<long long>(ticks / seconds) << "\n";
+    if (checksum != replay.finalChecksum)
+    {
+        std::cout << "MISMATCH: expected " << std::hex << replay.finalChecksum << " got " << checksum << "\n";
+        return 2;
+    }
+    std::cout << "checksum:    " << std::hex << checksum << " (match)\n";
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Plays game after game with the AutoPlayer, uncapped, for a fixed wall-clock
+// time and reports throughput, memory and level-clear times as it goes. A
+// steady ticks/s and a flat resident size over hours mean no leaks and no
+// slowdowns.
+// Usage: sim-soak [seconds] [--sim-hz N] [--report-every S] [--levels pack]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "input.hpp"
+#include "sim.hpp"
+
+const double MAX_LEVEL_SECONDS = 600; // simulated; a level taking longer counts as stalled
+
+long getPeakRssKb()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+long getCurrentRssKb()
+{
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0;
+    long resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Level-clear times in simulated seconds since the last report.
+struct LevelTimes
+{
+    long long count = 0;
+    double total = 0;
+    double longest = 0;
+
+    void add(double seconds)
+    {
+        count++;
+        total += seconds;
+        longest = std::max(longest, seconds);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    double duration = 60;
+    int simHz = 240;
+    double reportEvery = 10;
+    std::string levelsPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--sim-hz" && i + 1 < argc)
+        {
+            simHz = std::atoi(argv[++i]);
+        }
+        else if (arg == "--report-every" && i + 1 < argc)
+        {
+            reportEvery = std::atof(argv[++i]);
+        }
+        else if (arg == "--levels" && i + 1 < argc)
+        {
+            levelsPath = argv[++i];
+        }
+        else
+        {
+            duration = std::atof(argv[i]);
+        }
+    }
+    if (duration <= 0 || simHz <= 0 || reportEvery <= 0)
+    {
+        std::cerr << "Usage: sim-soak [seconds] [--sim-hz N] [--report-every S] [--levels pack]\n";
+        return 1;
+    }
+
+    LevelPack levelPack;
+    if (!levelsPath.empty() && !levelPack.open(levelsPath))
+    {
+        std::cerr << "Error loading level pack " << levelsPath << "\n";
+        return 1;
+    }
+
+    GameSim sim(1.0f / simHz, 1);
+    if (!levelsPath.empty())
+    {
+        sim.setLevelPack(&levelPack);
+        sim.reset(sim.getSeed());
+    }
+    AutoPlayer player;
+
+    long long ticks = 0;
+    long long games = 0;
+    long long stalled = 0;
+    long long levelTicks = 0;
+    LevelTimes interval;
+    LevelTimes overall;
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    long long lastReportTicks = 0;
+    std::printf("%8s %12s %7s %7s %10s %10s %10s %10s\n", "elapsed", "ticks/s", "games", "levels", "level avg", "level max",
+                "rss kb", "peak kb");
+    while (true)
+    {
+        // Check the clock every few thousand steps, not every step.
+        for (int i = 0; i < 4096; ++i)
+        {
+            StepResult result = sim.step(player.next(sim));
+            ticks++;
+            levelTicks++;
+            if (result.levelCleared)
+            {
+                interval.add(levelTicks * sim.getDt());
+                overall.add(levelTicks * sim.getDt());
+                levelTicks = 0;
+            }
+            if (result.gameFinished || levelTicks * sim.getDt() > MAX_LEVEL_SECONDS)
+            {
+                stalled += result.gameFinished ? 0 : 1;
+                games++;
+                levelTicks = 0;
+                sim.reset(sim.getSeed() + 1);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        double sinceReport = std::chrono::duration<double>(now - lastReport).count();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (sinceReport >= reportEvery || elapsed >= duration)
+        {
+            std::printf("%7.0fs %12.0f %7lld %7lld %9.1fs %9.1fs %10ld %10ld\n", elapsed,
+                        (ticks - lastReportTicks) / sinceReport, games, overall.count,
+                        interval.count ? interval.total / interval.count : 0.0, interval.longest, getCurrentRssKb(),
+                        getPeakRssKb());
+            std::fflush(stdout);
+            interval = LevelTimes();
+            lastReport = now;
+            lastReportTicks = ticks;
+        }
+        if (elapsed >= duration)
+        {
+            double seconds = std::chrono::duration<double>(now - start).count();
+            std::cout << "ticks:       " << ticks << "\n";
+            std::cout << "ticks/s:     " << static_cast<long long>(ticks / seconds) << "\n";
+            std::cout << "games:       " << games << " (" << stalled << " stalled)\n";
+            std::cout << "levels:      " << overall.count << ", avg " << (overall.count ? overall.total / overall.count : 0.0)
+                      << "s, max " << overall.longest << "s simulated\n";
+            std::cout << "peak rss kb: " << getPeakRssKb() << "\n";
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,255 @@
+#include "sim_thread.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// Simulation time the thread catches up at most after a stall; the rest is dropped.
+const std::chrono::milliseconds MAX_CATCH_UP(250);
+const std::size_t REWIND_BUDGET = 16 << 20; // bytes; minutes of a normal game, seconds with stress balls
+}
+
+int FrameSnapshot::getBrickHitPoints(int i) const
+{
+    auto entry = std::lower_bound(damagedBricks.begin(), damagedBricks.end(), i,
+                                  [](const BrickHitPoints &brick, int index) { return brick.index < index; });
+    return entry != damagedBricks.end() && entry->index == i ? entry->hitPoints : brickLayout->getHitPoints(i);
+}
+
+void SnapshotCapture::updateDamage(const BrickStore &bricks, int index)
+{
+    auto entry = std::lower_bound(damagedBricks.begin(), damagedBricks.end(), index,
+                                  [](const BrickHitPoints &brick, int i) { return brick.index < i; });
+    bool listed = entry != damagedBricks.end() && entry->index == index;
+    if (!bricks.isAlive(index) || bricks.getHitPoints(index) == brickLayout->getHitPoints(index))
+    {
+        if (listed)
+        {
+            damagedBricks.erase(entry);
+        }
+    }
+    else if (listed)
+    {
+        entry->hitPoints = bricks.getHitPoints(index);
+    }
+    else
+    {
+        damagedBricks.insert(entry, {index, bricks.getHitPoints(index)});
+    }
+}
+
+void SnapshotCapture::capture(const GameSim &sim, FrameSnapshot &snapshot)
+{
+    snapshot.dt = sim.getDt();
+    snapshot.paddle = sim.getPaddle();
+    snapshot.balls = sim.getBalls();
+    snapshot.bonuses.assign(sim.getBonuses().begin(), sim.getBonuses().end());
+
+    // The layout itself only changes between levels; copy it once and share it.
+    const BrickStore &bricks = sim.getBricks();
+    if (!brickLayout || brickLayoutVersion != sim.getBrickLayoutVersion())
+    {
+        brickLayout = std::make_shared<const BrickStore>(bricks);
+        brickLayoutVersion = sim.getBrickLayoutVersion();
+        brickStateVersion = sim.getBrickStateVersion() - 1;
+    }
+
+    // Follow the sim's change list; only a loaded state or an overflowing
+    // list makes this look at every brick.
+    const std::vector<int> &changes = sim.getBrickChanges();
+    if (brickStateVersion != sim.getBrickStateVersion())
+    {
+        damagedBricks.clear();
+        for (int i = 0; i < bricks.size(); ++i)
+        {
+            if (bricks.isAlive(i) && bricks.getHitPoints(i) != brickLayout->getHitPoints(i))
+            {
+                damagedBricks.push_back({i, bricks.getHitPoints(i)});
+            }
+        }
+        brickStateVersion = sim.getBrickStateVersion();
+        brickChangesRead = changes.size();
+    }
+    for (; brickChangesRead < changes.size(); ++brickChangesRead)
+    {
+        updateDamage(bricks, changes[brickChangesRead]);
+    }
+
+    snapshot.brickLayout = brickLayout;
+    snapshot.brickLayoutVersion = brickLayoutVersion;
+    snapshot.aliveBricks = bricks.getAliveBits();
+    snapshot.damagedBricks = damagedBricks;
+
+    snapshot.level = sim.getLevel();
+    snapshot.lives = sim.getLives();
+    snapshot.score = sim.getScore();
+    snapshot.finished = sim.isFinished();
+}
+
+SimThread::SimThread(GameSim &sim, InputSource &input) : sim(sim), input(input), rewind(REWIND_BUDGET)
+{
+    sim.setProfiler(&profiler);
+    thread = std::thread(&SimThread::run, this);
+}
+
+SimThread::~SimThread()
+{
+    stop();
+}
+
+std::uint64_t SimThread::start(std::uint64_t seed)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    startRequested = true;
+    startSeed = seed;
+    wake.notify_one();
+    return ++requestedGame;
+}
+
+void SimThread::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        wake.notify_one();
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+void SimThread::run()
+{
+    while (true)
+    {
+        std::uint64_t seed;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || startRequested; });
+            if (stopping)
+            {
+                return;
+            }
+            startRequested = false;
+            seed = startSeed;
+            game = requestedGame;
+        }
+        play(seed);
+    }
+}
+
+// Steps one game in real time until it finishes or another start() or stop()
+// comes in. Every wake-up runs the steps that have come due and publishes one
+// snapshot, so the window thread never holds up the simulation.
+void SimThread::play(std::uint64_t seed)
+{
+    typedef FrameSnapshot::Clock Clock;
+    const auto dt = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(sim.getDt()));
+
+    sim.reset(seed);
+    replay.simHz = static_cast<std::uint32_t>(1 / sim.getDt() + 0.5f);
+    replay.seed = seed;
+    replay.inputs.clear();
+    replay.finalChecksum = 0;
+    bricksHit = 0;
+    levelsCleared = 0;
+    rewind.clear();
+    rewind.push(sim);
+    if (observer)
+    {
+        observer->onStep(sim);
+    }
+
+    Clock::time_point nextStep = Clock::now();
+    publish(nextStep - dt);
+    while (!sim.isFinished())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (wake.wait_until(lock, nextStep, [this]() { return stopping || startRequested; }))
+            {
+                return;
+            }
+        }
+
+        profiler.beginFrame();
+        handleQuickSave();
+        Clock::time_point now = Clock::now();
+        if (now - nextStep > MAX_CATCH_UP)
+        {
+            nextStep = now - MAX_CATCH_UP;
+        }
+        while (nextStep <= now && !sim.isFinished())
+        {
+            nextStep += dt;
+            if (rewinding.load(std::memory_order_relaxed))
+            {
+                if (rewind.stepBack(sim))
+                {
+                    replay.inputs.resize(recording ? sim.getTick() : 0);
+                    if (observer)
+                    {
+                        observer->onStep(sim);
+                    }
+                }
+                continue;
+            }
+            SimInput stepInput = input.next(sim);
+            StepResult result = sim.step(stepInput);
+            rewind.push(sim);
+            if (observer)
+            {
+                observer->onStep(sim);
+            }
+            if (recording)
+            {
+                replay.inputs.push_back(packInput(stepInput));
+            }
+            bricksHit += result.bricksHit;
+            levelsCleared += result.levelCleared ? 1 : 0;
+        }
+        if (sim.isFinished() && recording)
+        {
+            replay.finalChecksum = sim.checksum();
+        }
+        profiler.endFrame();
+        publish(nextStep - dt);
+    }
+}
+
+void SimThread::handleQuickSave()
+{
+    if (quickSaveRequested.exchange(false, std::memory_order_relaxed))
+    {
+        sim.saveState(savedState);
+        savedReplay = replay;
+    }
+    if (quickLoadRequested.exchange(false, std::memory_order_relaxed) && !savedState.empty() &&
+        sim.loadState(savedState))
+    {
+        replay = savedReplay;
+        rewind.clear();
+        rewind.push(sim);
+        if (observer)
+        {
+            observer->onStep(sim);
+        }
+    }
+}
+
+void SimThread::publish(FrameSnapshot::Clock::time_point stepTime)
+{
+    FrameSnapshot &snapshot = snapshots.getWriteBuffer();
+    capture.capture(sim, snapshot);
+    snapshot.game = game;
+    snapshot.stepTime = stepTime;
+    snapshot.bricksHit = bricksHit;
+    snapshot.levelsCleared = levelsCleared;
+    snapshot.inputEvent = input.getLastEventId();
+    for (int phase = 0; phase < static_cast<int>(ProfilePhase::Count); ++phase)
+    {
+        snapshot.phaseMs[phase] = profiler.getPhaseAverage(static_cast<ProfilePhase>(phase));
+    }
+    snapshots.publish();
+}
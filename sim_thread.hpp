@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "input.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "rewind.hpp"
+#include "sim.hpp"
+#include "triple_buffer.hpp"
+
+// A brick whose hit points differ from those in the snapshot's layout copy.
+struct BrickHitPoints
+{
+    int index;
+    int hitPoints;
+};
+
+// Everything the window thread needs to draw a frame and react to the game,
+// copied out of the GameSim after a batch of steps. Event counts are running
+// totals for the game, so a snapshot the window thread never sees loses
+// nothing.
+struct FrameSnapshot
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::uint64_t game = 0; // SimThread::start() call this snapshot belongs to
+    Clock::time_point stepTime;
+    float dt = 0;
+
+    Paddle paddle{0, 0};
+    std::vector<Ball> balls;
+    std::vector<Bonus> bonuses;
+
+    // Shared per layout; aliveBricks has one bit per brick of it, and
+    // damagedBricks lists by index the live bricks whose hit points changed
+    // since the layout was copied, usually a handful.
+    std::shared_ptr<const BrickStore> brickLayout;
+    unsigned brickLayoutVersion = 0;
+    std::vector<std::uint64_t> aliveBricks;
+    std::vector<BrickHitPoints> damagedBricks;
+
+    int level = 0;
+    int lives = 0;
+    int score = 0;
+    bool finished = false;
+    long long bricksHit = 0;
+    int levelsCleared = 0;
+    std::uint64_t inputEvent = 0; // InputSource::getLastEventId() after the last step
+
+    // Average cost of the simulation phases on the sim thread, in ms.
+    double phaseMs[static_cast<int>(ProfilePhase::Count)] = {};
+
+    bool isBrickAlive(int i) const { return (aliveBricks[i >> 6] >> (i & 63)) & 1; }
+    // Hit points left on a live brick.
+    int getBrickHitPoints(int i) const;
+
+    // How far the window is between the last two steps, for interpolation.
+    float getAlpha(Clock::time_point now) const
+    {
+        float alpha = std::chrono::duration<float>(now - stepTime).count() / dt;
+        return alpha < 0 ? 0 : alpha > 1 ? 1 : alpha;
+    }
+};
+
+// Fills FrameSnapshots from a GameSim. The brick layout is copied only when
+// a new one was loaded and shared between snapshots otherwise; damaged bricks
+// are kept up to date from the sim's brick change list. Fields that do not
+// come from the sim (game, stepTime, event counts, phase times) are left to
+// the caller.
+class SnapshotCapture
+{
+public:
+    void capture(const GameSim &sim, FrameSnapshot &snapshot);
+
+private:
+    void updateDamage(const BrickStore &bricks, int index);
+
+    std::shared_ptr<const BrickStore> brickLayout;
+    unsigned brickLayoutVersion = 0;
+    unsigned brickStateVersion = 0;
+    std::size_t brickChangesRead = 0;
+    std::vector<BrickHitPoints> damagedBricks;
+};
+
+// Told about every change of a SimThread's game, on the sim thread: each
+// step, each rewind step and each new or loaded game.
+class StepObserver
+{
+public:
+    virtual ~StepObserver() = default;
+    virtual void onStep(const GameSim &sim) = 0;
+};
+
+// Runs a GameSim on its own thread at its fixed step rate, independent of
+// how long the window takes to present. Each batch of steps is published as
+// a FrameSnapshot through a lock-free triple buffer. The sim, the input source
+// and the replay recording belong to this thread from construction on.
+class SimThread
+{
+public:
+    SimThread(GameSim &sim, InputSource &input);
+    ~SimThread();
+
+    SimThread(const SimThread &) = delete;
+    SimThread &operator=(const SimThread &) = delete;
+
+    // Call before the first start().
+    void setRecording(bool enabled) { recording = enabled; }
+    void setStepObserver(StepObserver *stepObserver) { observer = stepObserver; }
+    void setTracing(bool enabled) { profiler.setTracing(enabled); }
+
+    // Starts a new game and returns its id, which its snapshots carry. The
+    // game runs until it finishes or the next start().
+    std::uint64_t start(std::uint64_t seed);
+
+    // While rewinding, each due step loads the state from one step earlier
+    // instead of stepping forward, back to the oldest state still held.
+    void setRewinding(bool enabled) { rewinding.store(enabled, std::memory_order_relaxed); }
+
+    // One quick-save slot, taken and restored before the next batch of
+    // steps. Loading works across games and brings the recording with it.
+    void quickSave() { quickSaveRequested.store(true, std::memory_order_relaxed); }
+    void quickLoad() { quickLoadRequested.store(true, std::memory_order_relaxed); }
+
+    // Takes the newest snapshot if one was published; false if nothing new.
+    bool acquire() { return snapshots.acquire(); }
+    const FrameSnapshot &getSnapshot() const { return snapshots.getReadBuffer(); }
+
+    // The finished game's seed, inputs and checksum. Valid once a snapshot of
+    // the game shows it finished, until the next start().
+    const Replay &getRecording() const { return replay; }
+
+    // Joins the thread; afterwards the profiler can be read.
+    void stop();
+    const FrameProfiler &getProfiler() const { return profiler; }
+
+private:
+    void run();
+    void play(std::uint64_t seed);
+    void handleQuickSave();
+    void publish(FrameSnapshot::Clock::time_point stepTime);
+
+    GameSim &sim;
+    InputSource &input;
+    StepObserver *observer = nullptr;
+    FrameProfiler profiler;
+    TripleBuffer<FrameSnapshot> snapshots;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool startRequested = false;
+    std::uint64_t startSeed = 0;
+    std::uint64_t requestedGame = 0;
+    std::atomic<bool> rewinding{false};
+    std::atomic<bool> quickSaveRequested{false};
+    std::atomic<bool> quickLoadRequested{false};
+
+    // Only touched by the sim thread.
+    std::uint64_t game = 0;
+    bool recording = false;
+    Replay replay;
+    RewindBuffer rewind;
+    std::vector<std::uint8_t> savedState;
+    Replay savedReplay;
+    long long bricksHit = 0;
+    int levelsCleared = 0;
+    SnapshotCapture capture;
+
+    std::thread thread;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+// Constants and plain value types shared by the headless simulation modules.
+
+const int WINDOW_WIDTH = 800;
+const int WINDOW_HEIGHT = 600;
+const int PADDLE_WIDTH = 200;
+const int PADDLE_HEIGHT = 20;
+const int BALL_RADIUS = 10;
+const int BRICK_WIDTH = 60;
+const int BRICK_HEIGHT = 20;
+const int BRICKS_PER_ROW = 10;
+const int BRICK_ROWS = 5;
+const int MAX_LIVES = 3;
+const int BUILTIN_LEVELS = 2; // random layouts used when no level pack is loaded
+const float BONUS_FALL_SPEED = 100.0f; // pixels per second
+const float BONUS_DURATION = 12.0f;    // seconds
+const int PADDLE_ENLARGED_WIDTH = 300;
+const int PADDLE_SHRUNKEN_WIDTH = 100;
+const float PADDLE_SPEED = 1000.0f; // pixels per second
+const float BALL_SPEED_X = 50.0f;   // pixels per second
+const float BALL_SPEED_Y = -300.0f; // pixels per second
+const int MAX_COLLISION_ITERATIONS = 16; // per ball per step
+const int MAX_BALLS = 4096;
+const int MAX_BONUSES = 1024; // falling at once; more are dropped
+const float MULTI_BALL_SPLIT_COS = 0.8660254f; // split balls leave at +-30 degrees
+const float MULTI_BALL_SPLIT_SIN = 0.5f;
+const int PARALLEL_BALL_THRESHOLD = 64; // fewer balls than this are moved on one thread
+const int BALLS_PER_CHUNK = 32;
+
+enum class BonusType
+{
+    None,
+    EnlargePaddle,
+    ShrinkPaddle,
+    Fireball,
+    MultiBall
+};
+
+struct Vec2
+{
+    float x;
+    float y;
+};
+
+inline Vec2 operator+(Vec2 a, Vec2 b) { return {a.x + b.x, a.y + b.y}; }
+inline Vec2 operator-(Vec2 a, Vec2 b) { return {a.x - b.x, a.y - b.y}; }
+inline Vec2 operator*(Vec2 a, float s) { return {a.x * s, a.y * s}; }
+
+inline Vec2 rotate(Vec2 v, float cosAngle, float sinAngle)
+{
+    return {v.x * cosAngle - v.y * sinAngle, v.x * sinAngle + v.y * cosAngle};
+}
+
+inline Vec2 lerp(Vec2 from, Vec2 to, float alpha)
+{
+    return from + (to - from) * alpha;
+}
+
+struct Rect
+{
+    float left;
+    float top;
+    float width;
+    float height;
+
+    // Same rule as sf::FloatRect::intersects: touching edges do not count.
+    bool intersects(const Rect &other) const
+    {
+        return left < other.left + other.width && other.left < left + width &&
+               top < other.top + other.height && other.top < top + height;
+    }
+};
+
+// Gameplay tunables that can change without a rebuild. The defaults are the
+// shipped game; sim-batch sweeps them to compare balance changes.
+struct SimConfig
+{
+    int bonusDropOneIn = 5;             // one brick in this many hides a bonus
+    int bonusWeights[4] = {1, 1, 1, 1}; // enlarge, shrink, fireball, multi-ball
+    float bonusDuration = BONUS_DURATION;
+    float paddleWidth = PADDLE_WIDTH;
+    float paddleEnlargedWidth = PADDLE_ENLARGED_WIDTH;
+    float paddleShrunkenWidth = PADDLE_SHRUNKEN_WIDTH;
+    float paddleSpeed = PADDLE_SPEED;
+    Vec2 ballVelocity{BALL_SPEED_X, BALL_SPEED_Y};
+    int lives = MAX_LIVES;
+};
@@ -0,0 +1,170 @@
+// Loopback test for spectator streaming. Plays a game with the AutoPlayer in
+// real time, streams it through a SpectatorHost to viewers on localhost,
+// each polling on its own thread, and reports the bandwidth per viewer, the
+// send-to-decode lag and whether every viewer's last state matches the
+// host's state of the same step.
+// --levels plays a level pack, to stream brick fields too large for one packet.
+// Usage: spectate-test [seconds] [--viewers N] [--sim-hz N] [--loss PERCENT] [--port P]
+//                      [--levels pack]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "input.hpp"
+#include "level.hpp"
+#include "spectator.hpp"
+
+int main(int argc, char *argv[])
+{
+    double seconds = 10;
+    int viewerCount = 4;
+    int simHz = 240;
+    double lossPercent = 0;
+    int port = 0;
+    std::string levelsPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--viewers" && i + 1 < argc)
+        {
+            viewerCount = std::atoi(argv[++i]);
+        }
+        else if (arg == "--sim-hz" && i + 1 < argc)
+        {
+            simHz = std::atoi(argv[++i]);
+        }
+        else if (arg == "--loss" && i + 1 < argc)
+        {
+            lossPercent = std::atof(argv[++i]);
+        }
+        else if (arg == "--port" && i + 1 < argc)
+        {
+            port = std::atoi(argv[++i]);
+        }
+        else if (arg == "--levels" && i + 1 < argc)
+        {
+            levelsPath = argv[++i];
+        }
+        else
+        {
+            seconds = std::atof(argv[i]);
+        }
+    }
+    if (seconds <= 0 || viewerCount <= 0 || simHz <= 0 || lossPercent < 0 || lossPercent >= 100 || port < 0 || port > 65535)
+    {
+        std::cerr << "Usage: spectate-test [seconds] [--viewers N] [--sim-hz N] [--loss PERCENT] [--port P] "
+                     "[--levels pack]\n";
+        return 1;
+    }
+    LevelPack levelPack;
+    if (!levelsPath.empty() && !levelPack.open(levelsPath))
+    {
+        std::cerr << "Error loading level pack " << levelsPath << "\n";
+        return 1;
+    }
+
+    SpectatorHost host;
+    if (!host.open(static_cast<unsigned short>(port)))
+    {
+        std::cerr << "Cannot bind port " << port << "\n";
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<SpectatorClient>> viewers;
+    for (int i = 0; i < viewerCount; ++i)
+    {
+        viewers.emplace_back(new SpectatorClient());
+        viewers.back()->setSimulatedLoss(static_cast<float>(lossPercent / 100), i + 1);
+        if (!viewers.back()->connect(sf::IpAddress::LocalHost, host.getPort()))
+        {
+            std::cerr << "Viewer " << i << " cannot bind a port\n";
+            return 1;
+        }
+    }
+    std::atomic<bool> running{true};
+    std::vector<std::thread> viewerThreads;
+    for (auto &viewer : viewers)
+    {
+        SpectatorClient *client = viewer.get();
+        viewerThreads.emplace_back([client, &running]()
+                                   {
+                                       while (running.load())
+                                       {
+                                           client->poll();
+                                           std::this_thread::sleep_for(std::chrono::microseconds(200));
+                                       }
+                                       client->poll();
+                                   });
+    }
+
+    // Wait for the viewers' joins, then play. Games restart until time is up.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    GameSim sim(1.0f / simHz, 1);
+    if (!levelsPath.empty())
+    {
+        sim.setLevelPack(&levelPack);
+        sim.reset(1);
+    }
+    AutoPlayer player(20, 1);
+    std::vector<std::uint64_t> checksums(1, 0); // by host sequence
+    typedef std::chrono::steady_clock Clock;
+    const auto dt = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / simHz));
+    Clock::time_point start = Clock::now();
+    Clock::time_point nextStep = start;
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    int games = 1;
+    while (nextStep < end)
+    {
+        std::this_thread::sleep_until(nextStep);
+        nextStep += dt;
+        sim.step(player.next(sim));
+        if (sim.isFinished())
+        {
+            sim.reset(sim.getSeed() + 1);
+            games++;
+        }
+        host.onStep(sim);
+        if (host.getSequence() == checksums.size())
+        {
+            checksums.push_back(sim.checksum());
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    running = false;
+    for (auto &thread : viewerThreads)
+    {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("viewers:       %d (host sees %d)\n", viewerCount, host.getViewerCount());
+    std::printf("sim hz:        %d\n", simHz);
+    std::printf("games:         %d\n", games);
+    std::printf("states:        %u\n", host.getSequence());
+    std::printf("sent:          %lld states, %lld packets\n", host.getStatesSent(), host.getPacketsSent());
+    std::printf("keyframes:     %.2f%%\n", 100.0 * host.getKeyframesSent() / std::max(1LL, host.getStatesSent()));
+    std::printf("fragmented:    %lld\n", host.getFragmentedStates());
+    std::printf("KB/s/viewer:   %.1f\n", host.getBytesSent() / 1024.0 / elapsed / viewerCount);
+    std::printf("B/state:       %.1f\n", static_cast<double>(host.getBytesSent()) / std::max(1LL, host.getStatesSent()));
+    bool allMatch = true;
+    for (int i = 0; i < viewerCount; ++i)
+    {
+        const SpectatorClient &viewer = *viewers[i];
+        GameSim mirror(1.0f / simHz, 0);
+        bool match = viewer.hasState() && mirror.loadState(viewer.getState()) &&
+                     viewer.getSequence() < checksums.size() && mirror.checksum() == checksums[viewer.getSequence()];
+        allMatch &= match;
+        const LatencyRecorder &lag = viewer.getLag();
+        std::printf("viewer %-2d      seq %u  undecodable %lld  lag ms p50 %.3f  p95 %.3f  p99 %.3f  max %.3f  %s\n", i,
+                    viewer.getSequence(), viewer.getPacketsUndecodable(), lag.getPercentile(50),
+                    lag.getPercentile(95), lag.getPercentile(99), lag.getPercentile(100), match ? "match" : "MISMATCH");
+    }
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+#include "spectator.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "state_io.hpp"
+
+namespace
+{
+const std::uint32_t STREAM_MAGIC = 0x50535844; // "DXSP"
+const std::size_t STATE_HEADER_SIZE = 4 + 1 + 2 + 4 + 4 + 8 + 4 + 4 + 4;
+const std::size_t FRAGMENT_BYTES = 32 * 1024; // per datagram, so a frame's worth fits a viewer's receive buffer
+const std::uint32_t MAX_STATE_BYTES = 64 << 20;
+const std::chrono::seconds VIEWER_TIMEOUT(5);
+const std::chrono::milliseconds HELLO_INTERVAL(500); // viewer resends its ack while nothing arrives
+const int MAX_VIEWERS = 64;
+
+enum class Kind : std::uint8_t
+{
+    State = 1,
+    Ack = 2,
+    Cookie = 3
+};
+
+std::uint64_t getMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}
+
+bool SpectatorHost::open(unsigned short port, const sf::IpAddress &address)
+{
+    std::random_device entropy;
+    secret = (static_cast<std::uint64_t>(entropy()) << 32) | entropy();
+    socket.setBlocking(false);
+    return socket.bind(port, address) == sf::Socket::Done;
+}
+
+std::uint32_t SpectatorHost::getCookie(const sf::IpAddress &address, unsigned short port) const
+{
+    Rng mix(secret ^ ((static_cast<std::uint64_t>(address.toInteger()) << 16) | port));
+    return static_cast<std::uint32_t>(mix.next()) | 1; // never 0, which means "no cookie yet"
+}
+
+void SpectatorHost::receive()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::uint8_t buffer[64];
+    std::size_t received;
+    sf::IpAddress address;
+    unsigned short port;
+    while (socket.receive(buffer, sizeof(buffer), received, address, port) == sf::Socket::Done)
+    {
+        StateReader reader(buffer, received);
+        std::uint32_t magic = 0;
+        Kind kind = Kind::State;
+        std::uint32_t acked = 0;
+        std::uint32_t cookie = 0;
+        reader.read(magic);
+        reader.read(kind);
+        reader.read(acked);
+        reader.read(cookie);
+        if (!reader.isValid() || magic != STREAM_MAGIC || kind != Kind::Ack)
+        {
+            continue;
+        }
+        std::uint32_t expected = getCookie(address, port);
+        if (cookie != expected)
+        {
+            // Nothing is remembered about the sender, and the reply is
+            // smaller than what it sent.
+            packet.clear();
+            StateWriter writer(packet);
+            writer.add(STREAM_MAGIC);
+            writer.add(Kind::Cookie);
+            writer.add(expected);
+            socket.send(packet.data(), packet.size(), address, port);
+            continue;
+        }
+        auto viewer = std::find_if(viewers.begin(), viewers.end(), [&](const Viewer &v)
+                                   { return v.address == address && v.port == port; });
+        if (viewer == viewers.end())
+        {
+            if (static_cast<int>(viewers.size()) == MAX_VIEWERS)
+            {
+                continue;
+            }
+            viewers.push_back({address, port, 0, now});
+            viewer = viewers.end() - 1;
+        }
+        // Acks can arrive out of order; only a newer one moves the base.
+        if (acked > viewer->acked && acked <= sequence)
+        {
+            viewer->acked = acked;
+        }
+        viewer->lastHeard = now;
+    }
+    viewers.erase(std::remove_if(viewers.begin(), viewers.end(), [&](const Viewer &v)
+                                 { return now - v.lastHeard > VIEWER_TIMEOUT; }),
+                  viewers.end());
+}
+
+void SpectatorHost::onStep(const GameSim &sim)
+{
+    receive();
+    if (viewers.empty())
+    {
+        return;
+    }
+
+    SentState &current = history[++sequence % HISTORY];
+    current.sequence = sequence;
+    sim.saveState(current.bytes);
+    std::uint16_t simHz = static_cast<std::uint16_t>(1 / sim.getDt() + 0.5f);
+    std::uint64_t sendTime = getMicros();
+
+    for (auto &viewer : viewers)
+    {
+        // A viewer still receiving a large state gets its next fragment
+        // instead of a newer state.
+        Transfer &transfer = viewer.transfer;
+        if (!transfer.pending)
+        {
+            const SentState &base = history[viewer.acked % HISTORY];
+            bool useBase = viewer.acked != 0 && base.sequence == viewer.acked && base.bytes.size() == current.bytes.size();
+            if (useBase)
+            {
+                encodeStateDelta(base.bytes, current.bytes, delta);
+            }
+            const std::vector<std::uint8_t> &payload = useBase ? delta : current.bytes;
+            transfer.sequence = sequence;
+            transfer.base = useBase ? viewer.acked : 0;
+            transfer.sendTime = sendTime;
+            transfer.stateSize = static_cast<std::uint32_t>(current.bytes.size());
+            transfer.payload.assign(payload.begin(), payload.end());
+            transfer.offset = 0;
+            transfer.pending = true;
+            statesSent++;
+            keyframesSent += useBase ? 0 : 1;
+            fragmentedStates += payload.size() > FRAGMENT_BYTES ? 1 : 0;
+        }
+
+        std::size_t chunk = std::min(FRAGMENT_BYTES, transfer.payload.size() - transfer.offset);
+        packet.clear();
+        StateWriter writer(packet);
+        writer.add(STREAM_MAGIC);
+        writer.add(Kind::State);
+        writer.add(simHz);
+        writer.add(transfer.sequence);
+        writer.add(transfer.base);
+        writer.add(transfer.sendTime);
+        writer.add(transfer.stateSize);
+        writer.add(static_cast<std::uint32_t>(transfer.payload.size()));
+        writer.add(static_cast<std::uint32_t>(transfer.offset));
+        writer.addBytes(transfer.payload.data() + transfer.offset, chunk);
+        transfer.offset += chunk;
+        transfer.pending = transfer.offset < transfer.payload.size();
+        if (socket.send(packet.data(), packet.size(), viewer.address, viewer.port) == sf::Socket::Done)
+        {
+            bytesSent += packet.size();
+            packetsSent++;
+        }
+    }
+}
+
+bool SpectatorClient::connect(const sf::IpAddress &host, unsigned short port)
+{
+    hostAddress = host;
+    hostPort = port;
+    socket.setBlocking(false);
+    if (socket.bind(sf::Socket::AnyPort) != sf::Socket::Done)
+    {
+        return false;
+    }
+    lastHeard = Clock::now();
+    sendAck();
+    return true;
+}
+
+void SpectatorClient::setSimulatedLoss(float fraction, std::uint64_t seed)
+{
+    lossRate = fraction;
+    lossRng.seed(seed);
+}
+
+void SpectatorClient::sendAck()
+{
+    std::vector<std::uint8_t> ack;
+    StateWriter writer(ack);
+    writer.add(STREAM_MAGIC);
+    writer.add(Kind::Ack);
+    writer.add(sequence);
+    writer.add(cookie);
+    socket.send(ack.data(), ack.size(), hostAddress, hostPort);
+    lastAck = Clock::now();
+}
+
+bool SpectatorClient::poll()
+{
+    bool decoded = false;
+    packet.resize(sf::UdpSocket::MaxDatagramSize);
+    std::size_t received;
+    sf::IpAddress address;
+    unsigned short port;
+    while (socket.receive(packet.data(), packet.size(), received, address, port) == sf::Socket::Done)
+    {
+        if (address != hostAddress || port != hostPort ||
+            (lossRate > 0 && lossRng.below(1000000) < lossRate * 1000000))
+        {
+            continue;
+        }
+        Clock::time_point now = Clock::now();
+        bytesReceived += received;
+        packetsReceived++;
+        lastHeard = now;
+
+        StateReader reader(packet.data(), received);
+        std::uint32_t magic = 0;
+        Kind kind = Kind::Ack;
+        std::uint16_t simHz = 0;
+        std::uint32_t packetSequence = 0;
+        std::uint32_t baseSequence = 0;
+        std::uint64_t sendTime = 0;
+        std::uint32_t stateSize = 0;
+        std::uint32_t payloadSize = 0;
+        std::uint32_t offset = 0;
+        reader.read(magic);
+        reader.read(kind);
+        if (reader.isValid() && magic == STREAM_MAGIC && kind == Kind::Cookie)
+        {
+            std::uint32_t given = 0;
+            reader.read(given);
+            if (reader.isValid())
+            {
+                cookie = given;
+                sendAck();
+            }
+            continue;
+        }
+        reader.read(simHz);
+        reader.read(packetSequence);
+        reader.read(baseSequence);
+        reader.read(sendTime);
+        reader.read(stateSize);
+        reader.read(payloadSize);
+        reader.read(offset);
+        if (!reader.isValid() || magic != STREAM_MAGIC || kind != Kind::State || simHz == 0 ||
+            stateSize > MAX_STATE_BYTES || payloadSize > MAX_STATE_BYTES)
+        {
+            packetsUndecodable++;
+            continue;
+        }
+        // Late or duplicate, unless the sequence fell far back because the
+        // host restarted.
+        if (packetSequence <= sequence && sequence - packetSequence < HISTORY)
+        {
+            continue;
+        }
+
+        // Fragments of a large state arrive in order, one per host step; a
+        // gap drops the state and the host sends a fresh one after it.
+        const std::uint8_t *payload = packet.data() + STATE_HEADER_SIZE;
+        std::size_t chunk = received - STATE_HEADER_SIZE;
+        if (offset != 0 || chunk != payloadSize)
+        {
+            if (offset == 0)
+            {
+                assembly.sequence = packetSequence;
+                assembly.bytes.clear();
+            }
+            if (assembly.sequence != packetSequence || offset != assembly.bytes.size() || offset > payloadSize ||
+                chunk > payloadSize - offset)
+            {
+                assembly.sequence = 0;
+                packetsUndecodable++;
+                continue;
+            }
+            assembly.bytes.insert(assembly.bytes.end(), payload, payload + chunk);
+            if (assembly.bytes.size() < payloadSize)
+            {
+                continue;
+            }
+            assembly.sequence = 0;
+            payload = assembly.bytes.data();
+        }
+        ReceivedState &target = history[packetSequence % HISTORY];
+        const ReceivedState &base = history[baseSequence % HISTORY];
+        if (baseSequence == 0)
+        {
+            if (payloadSize != stateSize)
+            {
+                packetsUndecodable++;
+                continue;
+            }
+            target.bytes.assign(payload, payload + payloadSize);
+        }
+        else
+        {
+            if (base.sequence != baseSequence || base.bytes.size() != stateSize)
+            {
+                packetsUndecodable++;
+                continue;
+            }
+            if (&target != &base)
+            {
+                target.bytes = base.bytes;
+            }
+            if (!applyStateDelta(payload, payloadSize, target.bytes))
+            {
+                target.sequence = 0;
+                packetsUndecodable++;
+                continue;
+            }
+        }
+        target.sequence = packetSequence;
+        sequence = packetSequence;
+        dt = 1.0f / simHz;
+        stateTime = now;
+        lag.add((getMicros() - sendTime) / 1000.0);
+        decoded = true;
+    }
+
+    if (decoded || Clock::now() - lastAck > HELLO_INTERVAL)
+    {
+        sendAck();
+    }
+    return decoded;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "profiler.hpp"
+#include "sim_thread.hpp"
+
+// Streams a game to spectators over UDP for mirroring one cabinet on other
+// screens. The host sends every step's GameSim state to each viewer as a
+// delta against the newest state that viewer acknowledged, or whole when
+// that state is too old; a lost packet therefore only costs a larger next
+// one. States larger than a datagram go out in fragments, one per step, and
+// the viewer gets nothing newer until the last one is sent. Viewers join by sending acks to the host's port and are dropped after
+// a few seconds of silence. An ack only counts with the cookie the host gave
+// that address and port, which it hands out in a reply no larger than the
+// ack; a forged sender address therefore never gets states streamed to it.
+// States are raw GameSim states, so both ends must run the same build.
+//
+// Datagram layout: u32 "DXSP", u8 kind, then for Kind::State u16 sim hz,
+// u32 sequence, u32 base sequence (0 = whole state), u64 send time in
+// microseconds of the host's steady clock, u32 state size, u32 payload size,
+// u32 offset of this fragment in the payload and the state or delta bytes; for Kind::Ack u32 newest sequence the viewer decoded and u32
+// cookie (0 before the viewer has one); for Kind::Cookie u32 cookie.
+class SpectatorHost : public StepObserver
+{
+public:
+    // Binds port on address, only this machine by default; 0 picks a free
+    // port.
+    bool open(unsigned short port, const sf::IpAddress &address = sf::IpAddress::LocalHost);
+    unsigned short getPort() const { return socket.getLocalPort(); }
+
+    // Takes joins and acks, then sends the sim's state to every viewer.
+    // Call on the thread that steps the sim.
+    void onStep(const GameSim &sim) override;
+
+    std::uint32_t getSequence() const { return sequence; }
+    int getViewerCount() const { return static_cast<int>(viewers.size()); }
+
+    // Totals over all viewers since open().
+    long long getBytesSent() const { return bytesSent; }
+    long long getPacketsSent() const { return packetsSent; }
+    long long getStatesSent() const { return statesSent; }
+    long long getKeyframesSent() const { return keyframesSent; }
+    long long getFragmentedStates() const { return fragmentedStates; } // sent over several steps
+
+private:
+    static const int HISTORY = 64;
+
+    // The state or delta a viewer is being sent.
+    struct Transfer
+    {
+        bool pending = false;
+        std::uint32_t sequence = 0;
+        std::uint32_t base = 0;
+        std::uint64_t sendTime = 0;
+        std::uint32_t stateSize = 0;
+        std::vector<std::uint8_t> payload;
+        std::size_t offset = 0;
+    };
+
+    struct Viewer
+    {
+        sf::IpAddress address;
+        unsigned short port;
+        std::uint32_t acked;
+        std::chrono::steady_clock::time_point lastHeard;
+        Transfer transfer;
+    };
+
+    struct SentState
+    {
+        std::uint32_t sequence = 0;
+        std::vector<std::uint8_t> bytes;
+    };
+
+    void receive();
+    std::uint32_t getCookie(const sf::IpAddress &address, unsigned short port) const;
+
+    sf::UdpSocket socket;
+    std::uint64_t secret = 0; // picked at open(); cookies are derived from it
+    std::vector<Viewer> viewers;
+    SentState history[HISTORY];
+    std::uint32_t sequence = 0;
+    std::vector<std::uint8_t> delta;
+    std::vector<std::uint8_t> packet;
+    long long bytesSent = 0;
+    long long packetsSent = 0;
+    long long statesSent = 0;
+    long long keyframesSent = 0;
+    long long fragmentedStates = 0;
+};
+
+// The viewing end of a SpectatorHost stream. poll() takes whatever arrived
+// and keeps the newest state it could decode, acknowledging it so the host
+// can send deltas against it.
+class SpectatorClient
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    bool connect(const sf::IpAddress &host, unsigned short port);
+
+    // Receives everything pending; true if a newer state was decoded.
+    bool poll();
+
+    bool hasState() const { return sequence != 0; }
+    const std::vector<std::uint8_t> &getState() const { return history[sequence % HISTORY].bytes; }
+    std::uint32_t getSequence() const { return sequence; }
+    float getDt() const { return dt; }
+    Clock::time_point getStateTime() const { return stateTime; } // when the newest state arrived
+    Clock::time_point getLastHeard() const { return lastHeard; }
+
+    long long getBytesReceived() const { return bytesReceived; }
+    long long getPacketsReceived() const { return packetsReceived; }
+    long long getPacketsUndecodable() const { return packetsUndecodable; } // base state missing or malformed
+
+    // Send-to-decode time of every state. Only meaningful when the host runs
+    // on the same machine, as it compares the two ends' steady clocks.
+    const LatencyRecorder &getLag() const { return lag; }
+
+    // For the loopback harness: drop this fraction of incoming packets.
+    void setSimulatedLoss(float fraction, std::uint64_t seed);
+
+private:
+    static const int HISTORY = 64;
+
+    struct ReceivedState
+    {
+        std::uint32_t sequence = 0;
+        std::vector<std::uint8_t> bytes;
+    };
+
+    void sendAck();
+
+    sf::UdpSocket socket;
+    sf::IpAddress hostAddress;
+    unsigned short hostPort = 0;
+    std::uint32_t cookie = 0;
+    ReceivedState assembly; // fragments of a large state so far
+    ReceivedState history[HISTORY];
+    std::uint32_t sequence = 0;
+    float dt = 0;
+    Clock::time_point stateTime;
+    Clock::time_point lastHeard;
+    Clock::time_point lastAck;
+    std::vector<std::uint8_t> packet;
+    long long bytesReceived = 0;
+    long long packetsReceived = 0;
+    long long packetsUndecodable = 0;
+    LatencyRecorder lag;
+    float lossRate = 0;
+    Rng lossRng;
+};
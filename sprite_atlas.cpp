@@ -0,0 +1,199 @@
+#include "sprite_atlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "sim_types.hpp"
+
+namespace
+{
+const unsigned ATLAS_WIDTH = 512;
+const unsigned SPRITE_PADDING = 2; // transparent pixels between sprites
+
+// Grey level and coverage of one pixel; x and y are pixel centres in sprite
+// coordinates.
+typedef std::function<sf::Color(float x, float y)> Painter;
+
+sf::Color grey(float level, float coverage)
+{
+    auto clamp = [](float value) { return static_cast<sf::Uint8>(std::max(0.0f, std::min(255.0f, value))); };
+    return sf::Color(clamp(level), clamp(level), clamp(level), clamp(coverage * 255));
+}
+
+// Coverage of a shape with signed distance d (negative inside), one pixel of
+// antialiasing wide.
+float coverage(float distance)
+{
+    return std::max(0.0f, std::min(1.0f, 0.5f - distance));
+}
+
+// Raised tile: light top and left edges, dark bottom and right edges.
+Painter bevel(int width, int height)
+{
+    return [=](float x, float y)
+    {
+        float level = 210;
+        if (x < 2 || y < 2)
+            level = 255;
+        else if (x > width - 2 || y > height - 2)
+            level = 150;
+        return grey(level, 1);
+    };
+}
+
+// Bevelled tile with a zigzag crack across it.
+Painter cracked(int width, int height)
+{
+    Painter tile = bevel(width, height);
+    return [=](float x, float y)
+    {
+        float crackY = height / 2.0f + (std::abs(std::fmod(x, 12.0f) - 6) - 3) * 1.2f;
+        if (x > width * 0.2f && x < width * 0.8f && std::abs(y - crackY) < 0.8f)
+        {
+            return grey(90, 1);
+        }
+        return tile(x, y);
+    };
+}
+
+// Brushed plate with a rivet in each corner.
+Painter plate(int width, int height)
+{
+    return [=](float x, float y)
+    {
+        float level = 190 + 25 * std::sin(y * 2.1f);
+        if (x < 1 || y < 1 || x > width - 1 || y > height - 1)
+            level = 120;
+        float rivetX = std::min(x - 4, width - 4 - x);
+        float rivetY = std::min(y - 4, height - 4 - y);
+        if (std::hypot(rivetX, rivetY) < 1.8f)
+            level = 255;
+        return grey(level, 1);
+    };
+}
+
+// Capsule with a highlight along the top.
+Painter capsule(int width, int height, std::function<float(float, float)> icon = nullptr)
+{
+    return [=](float x, float y)
+    {
+        float radius = height / 2.0f;
+        float cx = std::max(radius, std::min(width - radius, x));
+        float distance = std::hypot(x - cx, y - radius) - radius;
+        float level = 235 - 70 * (y / height);
+        if (icon)
+        {
+            level -= icon(x, y);
+        }
+        return grey(level, coverage(distance));
+    };
+}
+
+Painter ball(bool fireball)
+{
+    return [=](float x, float y)
+    {
+        float distance = std::hypot(x - BALL_RADIUS, y - BALL_RADIUS) - BALL_RADIUS;
+        float highlight = std::hypot(x - BALL_RADIUS * 0.7f, y - BALL_RADIUS * 0.7f) / (2 * BALL_RADIUS);
+        float level = 255 - 120 * highlight;
+        if (fireball)
+        {
+            // A ring of flame around a white-hot core.
+            float ring = std::cos((distance + BALL_RADIUS) * 1.3f);
+            level = distance < -BALL_RADIUS / 2.0f ? 255 : 215 + 40 * ring;
+        }
+        return grey(level, coverage(distance));
+    };
+}
+
+// Bonus icons, darkening the capsule: outward or inward arrows, a dot, or
+// three dots.
+float arrows(float x, float y, bool outward, float width, float height)
+{
+    float offset = std::abs(y - height / 2);
+    float fromLeft = outward ? x - 3 : 12 - x;
+    float fromRight = outward ? width - 3 - x : x - (width - 12);
+    bool inLeft = fromLeft >= offset && fromLeft <= offset + 3 && x < width / 2;
+    bool inRight = fromRight >= offset && fromRight <= offset + 3 && x > width / 2;
+    return inLeft || inRight ? 130 : 0;
+}
+
+float dots(float x, float y, int count, float width, float height)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        float cx = width / 2 + (i - (count - 1) / 2.0f) * 7;
+        if (std::hypot(x - cx, y - height / 2) < 2.6f)
+        {
+            return 130;
+        }
+    }
+    return 0;
+}
+}
+
+SpriteAtlas::SpriteAtlas()
+{
+    struct Entry
+    {
+        Sprite sprite;
+        int width;
+        int height;
+        Painter paint;
+    };
+    const int bonusWidth = BRICK_WIDTH / 2;
+    const int bonusHeight = BRICK_HEIGHT / 2;
+    const Entry entries[] = {
+        {Sprite::PaddleEnlarged, PADDLE_ENLARGED_WIDTH, PADDLE_HEIGHT, capsule(PADDLE_ENLARGED_WIDTH, PADDLE_HEIGHT)},
+        {Sprite::Paddle, PADDLE_WIDTH, PADDLE_HEIGHT, capsule(PADDLE_WIDTH, PADDLE_HEIGHT)},
+        {Sprite::PaddleShrunken, PADDLE_SHRUNKEN_WIDTH, PADDLE_HEIGHT, capsule(PADDLE_SHRUNKEN_WIDTH, PADDLE_HEIGHT)},
+        {Sprite::Brick, BRICK_WIDTH, BRICK_HEIGHT, bevel(BRICK_WIDTH, BRICK_HEIGHT)},
+        {Sprite::BrickDamaged, BRICK_WIDTH, BRICK_HEIGHT, cracked(BRICK_WIDTH, BRICK_HEIGHT)},
+        {Sprite::BrickUnbreakable, BRICK_WIDTH, BRICK_HEIGHT, plate(BRICK_WIDTH, BRICK_HEIGHT)},
+        {Sprite::Ball, 2 * BALL_RADIUS, 2 * BALL_RADIUS, ball(false)},
+        {Sprite::Fireball, 2 * BALL_RADIUS, 2 * BALL_RADIUS, ball(true)},
+        {Sprite::BonusEnlarge, bonusWidth, bonusHeight,
+         capsule(bonusWidth, bonusHeight, [=](float x, float y) { return arrows(x, y, true, bonusWidth, bonusHeight); })},
+        {Sprite::BonusShrink, bonusWidth, bonusHeight,
+         capsule(bonusWidth, bonusHeight, [=](float x, float y) { return arrows(x, y, false, bonusWidth, bonusHeight); })},
+        {Sprite::BonusFireball, bonusWidth, bonusHeight,
+         capsule(bonusWidth, bonusHeight, [=](float x, float y) { return dots(x, y, 1, bonusWidth, bonusHeight); })},
+        {Sprite::BonusMultiBall, bonusWidth, bonusHeight,
+         capsule(bonusWidth, bonusHeight, [=](float x, float y) { return dots(x, y, 3, bonusWidth, bonusHeight); })},
+    };
+
+    // Pack left to right in shelves; entries are listed tallest first.
+    unsigned x = SPRITE_PADDING;
+    unsigned y = SPRITE_PADDING;
+    unsigned shelfHeight = 0;
+    sf::Vector2u positions[static_cast<int>(Sprite::Count)];
+    for (const auto &entry : entries)
+    {
+        if (x + entry.width + SPRITE_PADDING > ATLAS_WIDTH)
+        {
+            x = SPRITE_PADDING;
+            y += shelfHeight + SPRITE_PADDING;
+            shelfHeight = 0;
+        }
+        positions[static_cast<int>(entry.sprite)] = sf::Vector2u(x, y);
+        regions[static_cast<int>(entry.sprite)] = sf::FloatRect(x, y, entry.width, entry.height);
+        x += entry.width + SPRITE_PADDING;
+        shelfHeight = std::max<unsigned>(shelfHeight, entry.height);
+    }
+
+    sf::Image image;
+    image.create(ATLAS_WIDTH, y + shelfHeight + SPRITE_PADDING, sf::Color::Transparent);
+    for (const auto &entry : entries)
+    {
+        sf::Vector2u origin = positions[static_cast<int>(entry.sprite)];
+        for (int py = 0; py < entry.height; ++py)
+        {
+            for (int px = 0; px < entry.width; ++px)
+            {
+                image.setPixel(origin.x + px, origin.y + py, entry.paint(px + 0.5f, py + 0.5f));
+            }
+        }
+    }
+    texture.loadFromImage(image);
+}
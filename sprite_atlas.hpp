@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+enum class Sprite
+{
+    Brick,
+    BrickDamaged,
+    BrickUnbreakable,
+    Paddle,
+    PaddleEnlarged,
+    PaddleShrunken,
+    Ball,
+    Fireball,
+    BonusEnlarge,
+    BonusShrink,
+    BonusFireball,
+    BonusMultiBall,
+    Count
+};
+
+// Every game object sprite in one texture, so the playfield draws as textured
+// quads without switching textures. The sprites are painted at startup at the
+// size they are drawn, in light grey shades that the vertex color tints.
+class SpriteAtlas
+{
+public:
+    SpriteAtlas();
+
+    const sf::Texture &getTexture() const { return texture; }
+    const sf::FloatRect &getRegion(Sprite sprite) const { return regions[static_cast<int>(sprite)]; }
+
+private:
+    sf::Texture texture;
+    sf::FloatRect regions[static_cast<int>(Sprite::Count)];
+};
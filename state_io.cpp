@@ -0,0 +1,89 @@
+#include "state_io.hpp"
+
+namespace
+{
+// A literal run ends at this many unchanged bytes in a row; shorter gaps cost
+// more as run headers than as literal bytes.
+const std::size_t MIN_ZERO_RUN = 4;
+
+void putVarint(std::vector<std::uint8_t> &out, std::size_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<std::uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+bool getVarint(const std::uint8_t *&data, const std::uint8_t *end, std::size_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7)
+    {
+        std::uint8_t byte = *data++;
+        value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+void encodeStateDelta(const std::vector<std::uint8_t> &from, const std::vector<std::uint8_t> &to,
+                      std::vector<std::uint8_t> &out)
+{
+    out.clear();
+    std::size_t size = to.size();
+    std::size_t i = 0;
+    while (true)
+    {
+        std::size_t zeroStart = i;
+        while (i < size && from[i] == to[i])
+        {
+            ++i;
+        }
+        if (i == size)
+        {
+            return;
+        }
+        std::size_t literalStart = i;
+        std::size_t same = 0;
+        for (; i < size && same < MIN_ZERO_RUN; ++i)
+        {
+            same = from[i] == to[i] ? same + 1 : 0;
+        }
+        std::size_t literalEnd = i - same;
+        i = literalEnd;
+        putVarint(out, literalStart - zeroStart);
+        putVarint(out, literalEnd - literalStart);
+        for (std::size_t j = literalStart; j < literalEnd; ++j)
+        {
+            out.push_back(from[j] ^ to[j]);
+        }
+    }
+}
+
+bool applyStateDelta(const std::uint8_t *delta, std::size_t size, std::vector<std::uint8_t> &state)
+{
+    const std::uint8_t *end = delta + size;
+    std::size_t position = 0;
+    while (delta < end)
+    {
+        std::size_t zeros;
+        std::size_t literal;
+        if (!getVarint(delta, end, zeros) || !getVarint(delta, end, literal) || zeros > state.size() - position ||
+            literal > state.size() - position - zeros || literal > static_cast<std::size_t>(end - delta))
+        {
+            return false;
+        }
+        position += zeros;
+        for (std::size_t i = 0; i < literal; ++i)
+        {
+            state[position++] ^= *delta++;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Byte streams for GameSim::saveState() and loadState(). Values are copied
+// in their in-memory representation, so a state is only meant to be loaded
+// by the same build that saved it.
+class StateWriter
+{
+public:
+    explicit StateWriter(std::vector<std::uint8_t> &out) : out(out) {}
+
+    template <typename T>
+    void add(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "states hold plain values only");
+        addBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void addArray(const std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "states hold plain values only");
+        add(static_cast<std::uint32_t>(values.size()));
+        addBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void addBytes(const void *data, std::size_t size)
+    {
+        std::size_t start = out.size();
+        out.resize(start + size);
+        if (size != 0)
+        {
+            std::memcpy(out.data() + start, data, size);
+        }
+    }
+
+private:
+    std::vector<std::uint8_t> &out;
+};
+
+// Delta between two states of the same size, as (zero run, literal run,
+// literal XOR bytes) triples up to the last byte that differs. Unchanged
+// stretches cost nothing, so consecutive game states differ by tens of bytes.
+void encodeStateDelta(const std::vector<std::uint8_t> &from, const std::vector<std::uint8_t> &to,
+                      std::vector<std::uint8_t> &out);
+
+// Applies a delta to state in place; being an XOR, applying it again undoes
+// it. Returns false if the delta is malformed or runs past the end of state,
+// which may then be partly changed.
+bool applyStateDelta(const std::uint8_t *delta, std::size_t size, std::vector<std::uint8_t> &state);
+
+// Reads what StateWriter wrote. Running past the end sets a sticky failure
+// instead of reading out of bounds; check isValid() once at the end.
+class StateReader
+{
+public:
+    StateReader(const std::uint8_t *data, std::size_t size) : data(data), end(data + size) {}
+
+    template <typename T>
+    void read(T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "states hold plain values only");
+        readBytes(&value, sizeof(T));
+    }
+
+    // Arrays longer than maxCount are rejected. Types without a default
+    // constructor pass fill, which is overwritten.
+    template <typename T>
+    void readArray(std::vector<T> &values, std::size_t maxCount, const T &fill = T())
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "states hold plain values only");
+        std::uint32_t count = 0;
+        read(count);
+        if (!valid || count > maxCount || count > static_cast<std::size_t>(end - data) / sizeof(T))
+        {
+            valid = false;
+            values.clear();
+            return;
+        }
+        values.assign(count, fill);
+        readBytes(values.data(), count * sizeof(T));
+    }
+
+    void readBytes(void *out, std::size_t size)
+    {
+        if (!valid || size > static_cast<std::size_t>(end - data))
+        {
+            valid = false;
+            return;
+        }
+        if (size != 0)
+        {
+            std::memcpy(out, data, size);
+        }
+        data += size;
+    }
+
+    bool isValid() const { return valid; }
+    bool isAtEnd() const { return data == end; }
+
+private:
+    const std::uint8_t *data;
+    const std::uint8_t *end;
+    bool valid = true;
+};
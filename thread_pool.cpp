@@ -0,0 +1,150 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+std::uint64_t packRange(std::uint32_t begin, std::uint32_t end)
+{
+    return (std::uint64_t(begin) << 32) | end;
+}
+
+std::uint32_t rangeBegin(std::uint64_t bounds)
+{
+    return static_cast<std::uint32_t>(bounds >> 32);
+}
+
+std::uint32_t rangeEnd(std::uint64_t bounds)
+{
+    return static_cast<std::uint32_t>(bounds);
+}
+}
+
+ThreadPool::ThreadPool(int threads)
+    : task(nullptr), busyWorkers(0), generation(0), stopping(false)
+{
+    if (threads <= 0)
+    {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    ranges.reset(new Range[threads]);
+    for (int i = 0; i < threads; ++i)
+    {
+        ranges[i].bounds = 0;
+    }
+    for (int i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+bool ThreadPool::claim(int self, int &chunk)
+{
+    std::atomic<std::uint64_t> &own = ranges[self].bounds;
+    std::uint64_t bounds = own.load();
+    while (rangeBegin(bounds) < rangeEnd(bounds))
+    {
+        if (own.compare_exchange_weak(bounds, packRange(rangeBegin(bounds) + 1, rangeEnd(bounds))))
+        {
+            chunk = rangeBegin(bounds);
+            return true;
+        }
+    }
+
+    // Own range is empty: take the back half of someone else's.
+    int threads = getThreadCount();
+    for (int offset = 1; offset < threads; ++offset)
+    {
+        std::atomic<std::uint64_t> &victim = ranges[(self + offset) % threads].bounds;
+        bounds = victim.load();
+        while (rangeBegin(bounds) < rangeEnd(bounds))
+        {
+            std::uint32_t end = rangeEnd(bounds);
+            std::uint32_t split = end - (end - rangeBegin(bounds) + 1) / 2;
+            if (victim.compare_exchange_weak(bounds, packRange(rangeBegin(bounds), split)))
+            {
+                chunk = split;
+                own.store(packRange(split + 1, end));
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::drain(int self)
+{
+    int chunk;
+    while (claim(self, chunk))
+    {
+        (*task)(chunk);
+    }
+}
+
+void ThreadPool::run(int chunks, const std::function<void(int)> &work)
+{
+    if (workers.empty() || chunks <= 1)
+    {
+        for (int chunk = 0; chunk < chunks; ++chunk)
+        {
+            work(chunk);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        int threads = getThreadCount();
+        for (int i = 0; i < threads; ++i)
+        {
+            ranges[i].bounds = packRange(static_cast<std::uint64_t>(chunks) * i / threads,
+                                         static_cast<std::uint64_t>(chunks) * (i + 1) / threads);
+        }
+        task = &work;
+        busyWorkers = static_cast<int>(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]
+              { return busyWorkers == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::workerLoop(int self)
+{
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [&]
+                  { return stopping || generation != seen; });
+        if (stopping)
+        {
+            return;
+        }
+        seen = generation;
+        lock.unlock();
+        drain(self);
+        lock.lock();
+        if (--busyWorkers == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
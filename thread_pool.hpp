@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. run() splits the chunk
+// indices evenly between the workers and the calling thread, and a thread that
+// runs out steals the back half of another thread's remaining range, so
+// chunks of uneven cost still balance. run() returns once every chunk is
+// done, so callers can treat it like a plain for loop.
+class ThreadPool
+{
+public:
+    // threads counts the calling thread; 0 picks the hardware concurrency.
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    void run(int chunks, const std::function<void(int)> &task);
+
+private:
+    // Unclaimed chunks [begin, end) of one thread, packed into one word so the
+    // owner and thieves claim with a single compare-and-swap.
+    struct alignas(64) Range
+    {
+        std::atomic<std::uint64_t> bounds;
+    };
+
+    bool claim(int self, int &chunk);
+    void workerLoop(int self);
+    void drain(int self);
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<Range[]> ranges;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)> *task;
+    int busyWorkers;
+    unsigned generation;
+    bool stopping;
+};
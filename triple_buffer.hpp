@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single-producer, single-consumer triple buffer. The producer
+// fills getWriteBuffer() and publish()es it; the consumer acquire()s the most
+// recently published buffer and reads it at leisure. Neither side ever waits,
+// and the consumer simply skips buffers it was too slow to see.
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Producer side.
+    T &getWriteBuffer() { return buffers[writeIndex]; }
+    void publish() { writeIndex = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK; }
+
+    // Consumer side. Returns false, keeping the current read buffer, when
+    // nothing new was published since the last acquire().
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+        {
+            return false;
+        }
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T &getReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;
+
+    T buffers[3];
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle{2};
+};